@@ -30,6 +30,9 @@
 #define EE_ADDR_CONF 0x10
 #define CMOS_SIZE 32
 
+#define FPGA_RESET_REQUEST 0xC3 // CPU reset request byte on the CMOS link (port 92h, KBC command FEh)
+#define CPU_RESET_US 10 // i486 warm reset needs 15 CLKs
+
 #define BAUD 57600 
 // 115200 can't be achieved with 16 MHz CLK
 
@@ -117,12 +120,21 @@ static inline void spi_write_byte(uint8_t b) {
     while (!(SPSR & (1<<SPIF)));
 }
 
-// Catch reset requests: FPGA reset (PF1 low) or button (PB4 low)
+// Catch reset requests: button (PB4 low)
+// FPGA requests come over the CMOS link instead of PF1, see cpu_reset_pulse
 static uint8_t reset_requested(void) {
     if (!(PINB & (1<<RESET_BTN_BIT))) return 1;
     return 0;
 }
 
+// Short CPU-only reset on a chipset request
+// FPGA configuration, CMOS and the CMOS link stay as they are
+static void cpu_reset_pulse(void) {
+    RESET_OUT_PORT |= (1<<RESET_OUT_BIT);
+    _delay_us(CPU_RESET_US);
+    RESET_OUT_PORT &= ~(1<<RESET_OUT_BIT);
+}
+
 
 static uint32_t bitstream_length(void) {
     return pgm_get_far_address(bitstream_end) - pgm_get_far_address(bitstream);
@@ -415,6 +427,9 @@ int main(void) {
                 cmos_rec_addr = 0;
                 cmos_rec_bit = 0;
                 cmos_rec_started = 1;
+            } else if(cmos_receiver_data==FPGA_RESET_REQUEST) { // port 92h / KBC reset
+                if(timer1_is_done()) cpu_reset_pulse(); // not while the long reset is held
+                cmos_receiver_data = 0;
             }
         } else {
             // Receive loop
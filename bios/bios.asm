@@ -12,6 +12,7 @@
 cpu 486
 
 %include "config.inc"
+%include "data/ebda.asm"
 
 
 	org 0 ; Real 0xF000:0x0000
@@ -28,7 +29,7 @@ image_start:
 times 0xFD - $ + image_start db 0xFF
 
 ; 0xF000:0x00FD - VBIOS jmp (F000:F065 JMPs to 00FD)
-jmp near int10
+jmp near int10_tty
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ; Entry point - 0xF000:0x0100
@@ -57,36 +58,9 @@ start:
 	mov sp, dx
 	
 
-	; Check if this restart is just an exit from protected mode
-	; and we need to resume execution of user program
-	; mov ax, [pmode_exit_cs]
-	; or ax, [pmode_exit_ip]
-	; jz normal_restart
-
-	; Zero values or the system will not restart properly
-	; mov word [pmode_exit_cs], 0
-	; mov word [pmode_exit_ip], 0
-
-	; SKIP PMODE EXIT CHECKS - reset is implemented incorrectly in the M8SBC
-	jmp normal_restart
-
-	; ======== unused ========
-	; Check NVRAM for a protected mode exit flag
-	mov al, 0x0F
-	out 0x70, al
-	jmp $+2
-	in al, 0x71
-	cmp al, 0x5
-	je pmode_exit
-	cmp al, 0xA
-	jne normal_restart
-
-pmode_exit:
-	; Resume execution in real mode	
-	push word [pmode_exit_cs]
-	push word [pmode_exit_ip]
-	retf
-	; ========================
+	; Exit from protected mode (CMOS shutdown code 05h/0Ah, resumes the
+	; user program), Ctrl-Alt-Del or software reset, sets BP for normal_restart
+	jmp warm_boot_check
 
 normal_restart:
 
@@ -100,11 +74,15 @@ normal_restart:
 	mov al, 0x03 ; POST 0x03 - PIC initialized
 	out 0x80, al
 
-	; base 64K memory test
+	; base 64K memory test, skipped on a warm boot to save time
+	; the warm boot state is kept in BP and put back by warm_boot_restore
+	test bp, bp
+	jnz base_memtest_done
 	xor ax, ax ; es = 0
 	mov es, ax 
     mov ds, ax
 %include "drivers/base_memtest.asm"
+base_memtest_done:
 	mov ax, 0x40 ; Setup segments back
 	mov ds, ax
 
@@ -136,30 +114,30 @@ erase_ints2:
 	; Fill used vectors
 	mov [0x00 * 4], word int00
 	mov [0x01 * 4], word int01
-	mov [0x02 * 4], word int02
+	mov [0x02 * 4], word profile_nmi
 	mov [0x03 * 4], word int03
 	mov [0x04 * 4], word int04
 	mov [0x05 * 4], word int05
 	mov [0x06 * 4], word int06
 	mov [0x07 * 4], word int07
-	mov [0x08 * 4], word int08
-	mov [0x09 * 4], word int09
+	mov [0x08 * 4], word int08_uptime
+	mov [0x09 * 4], word int09_post
 	mov [0x0A * 4], word empty_hw_int
-	mov [0x0B * 4], word empty_hw_int
-	mov [0x0C * 4], word int0c
+	mov [0x0B * 4], word serial_irq3
+	mov [0x0C * 4], word serial_irq4
 	mov [0x0D * 4], word empty_hw_int
 	mov [0x0E * 4], word empty_hw_int
 	mov [0x0F * 4], word empty_hw_int
-	mov [0x10 * 4], word int10
+	mov [0x10 * 4], word int10_tty
 	mov [0x11 * 4], word int11
 	mov [0x12 * 4], word int12
 	mov [0x13 * 4], word int13
 	mov [0x14 * 4], word int14
 	mov [0x15 * 4], word int15
-	mov [0x16 * 4], word int16
+	mov [0x16 * 4], word int16_idle
 	mov [0x17 * 4], word int17
 	mov [0x19 * 4], word int19
-	mov [0x1A * 4], word int1a
+	mov [0x1A * 4], word int1a_ext
 	mov [0x1D * 4], word video_init_table
 	mov [0x1E * 4], word int1e
 	mov [0x41 * 4], word int41
@@ -178,13 +156,16 @@ erase_ints2:
 	mov cx, 0x100 + bios_data_end - bios_data + 1
 	rep movsb
 
+	call warm_boot_restore
+	call timeline_start
+
 	; Display 'R' on the left top corner of the screen
 	mov ax, 0xB800
 	mov ds, ax
 	mov word [0], 0x0F00 + 'R'
 	
 	mov al, 0x05 ; POST 0x05 - IVT and BDA set up
-	out 0x80, al
+	call post_mark
 
 
 	;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -201,21 +182,7 @@ erase_ints2:
 	; Check if we have additional BIOS chips
 	mov ax, 0x40
 	mov ds, ax
-	mov word [bios_temp + 2], 0xC000
-	mov word [bios_temp], 2
-scan_roms:
-	mov ax, [bios_temp + 2]
-	mov es, ax
-	cmp [es:0], word 0xAA55
-	jnz no_rom
-	call far [bios_temp]
-no_rom:
-	mov ax, 0x40
-	mov ds, ax
-	mov ax, 0x1000
-	add [bios_temp + 2], ax
-	cmp word [bios_temp + 2], 0xF000
-	jnz scan_roms
+	call scan_roms
 
 	; int 42h needs to point to int 10h, not F000:F065
 	; Handled by vgavector.asm jumping to F000:00FD which jumps to BIOS int 10h
@@ -226,7 +193,7 @@ no_rom:
 
 
 	mov al, 0x06 ; POST 0x06 - ROM detection & execution done
-	out 0x80, al
+	call post_mark
 
 	; Set the text mode normal way	
 	mov ax, 3
@@ -239,7 +206,7 @@ no_rom:
 	int 10h
 
 	mov al, 0x07 ; POST 0x07 - Video set
-	out 0x80, al
+	call post_mark
 
 
 	; Display welcome message
@@ -259,10 +226,10 @@ no_rom:
 	call cache_enable
 
 	mov al, 0x08 ; POST 0x08 - Cache enabled
-	out 0x80, al
+	call post_mark
 
 	; C entry
-	call 0xF000:0x2000 
+	call 0xF000:C_BLOB_OFFSET
 
 	mov ah, 01h    ; Function: Set Cursor Shape
 	mov ch, 0Eh    ; Start Scan Line 
@@ -294,14 +261,16 @@ no_rom:
 
 	; Timer 0: 55 ms / 0xFFFF
 	; System timer connected to IRQ0
-	mov al, 0x36
+	; Mode 2, same rate as mode 3 but a latched count is linear (timeline)
+	mov al, 0x34
 	out 0x43, al
 	mov al, 0
 	out 0x40, al
 	out 0x40, al
+	call timeline_rebase
 
 	mov al, 0x09 ; POST 0x09 - PIT init done
-	out 0x80, al
+	call post_mark
 
 
 	;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -312,9 +281,11 @@ no_rom:
 
 	; If we reached this point -> we have disk and can boot now
 	mov si, msg_bootsector
-	call putsv
+	call linux_boot_check
 
 	; Load a very first sector from default boot drive
+	mov al, 0x0A ; POST 0x0A - Boot sector read
+	call post_mark
 	xor ax, ax
 	mov es, ax
 	mov bx, 0x7C00
@@ -371,6 +342,9 @@ no_rom:
 	xor bp, bp
 
 	; Start OS
+	mov al, 0x0B ; POST 0x0B - INT 19h handoff
+	call post_mark
+	xor ax, ax
 	jmp (0x0000):0x7C00
 
 
@@ -424,13 +398,8 @@ empty_int:
 
 %include "isr/int08_timer.asm"
 %include "isr/int09_keyboard.asm"
-%include "isr/int0c_comm.asm"
 %include "isr/int10_video.asm"
 %include "isr/int11.asm"
-%include "isr/int12.asm"
-%include "isr/int13_disk.asm"
-%include "isr/int14_comm.asm"
-%include "isr/int15_at.asm"
 %include "isr/int16_keyboard.asm"
 %include "isr/int17.asm"
 %include "isr/int19.asm"
@@ -556,6 +525,29 @@ hdd_sectors:
 %if ((check_size - bios_data) != 0xA8)
 %error BIOS parameter block data offset detected!
 %endif
+%if ((ide_multiple - bios_data) != 0xC4) || ((ide_sectors - bios_data) != 0xC8) || ((ide_pio_mode - bios_data) != 0xD2) || ((mem_total_kb - bios_data) != 0xD4) || ((bios_settings - bios_data) != 0xD6) || ((uptime_ticks - bios_data) != 0xD7) || ((tty_offset - bios_data) != 0xDE) || ((shadow_blocks - bios_data) != 0xE0)
+%error IDE and POST parameters offset does not match c_src/bda.h!
+%endif
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+; Code placed after the fixed tables, up to the C blob
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+
+%include "isr/int12.asm"
+%include "isr/int13_disk.asm"
+%include "isr/int15_at.asm"
+%include "isr/int1a_ext.asm"
+%include "isr/int16_idle.asm"
+%include "isr/int14_comm.asm"
+%include "isr/int10_tty.asm"
+%include "drivers/linuxboot.asm"
+%include "drivers/xmem.asm"
+%include "drivers/warmboot.asm"
+%include "drivers/timeline.asm"
+%include "drivers/shadow.asm"
+
+	; Fails to assemble if the code above runs into the C blob
+	times C_BLOB_OFFSET - $ + image_start db 0xFF
 
 ; moved to startvector.asm
 ; 	; Fill unused area with NOPs
@@ -36,6 +36,7 @@ void about_display() {
     kb_clear_buffer();
 
     while(1) {
+        vga_flush();
         if(kb_is_available()) {
             uint8_t scancode = kb_get_scancode();
             if(scancode==0x01) { // ESC
@@ -0,0 +1,43 @@
+#ifndef BDA_H
+#define BDA_H
+
+#include <stdint.h>
+
+// SeaPig fields of the BIOS Data Area, used by the assembly BIOS at runtime
+// Layout must match data/biosdata.asm (starts at 0x40:0xC4)
+
+#define BDA_PARAMS_ADDR 0x4C4
+
+#define BDA_IDE_LBA     0x01
+#define BDA_IDE_LBA48   0x02
+#define BDA_IDE_IORDY   0x04
+
+#define BDA_POST_WARM   0x01
+#define BDA_POST_LINUX  0x02 // linux.c loaded a kernel, bios.asm starts it instead of the boot sector
+
+#define BDA_SETTING_LBA         0x01
+#define BDA_SETTING_DISK_CACHE  0x02
+#define BDA_SETTING_FULL_POST   0x04
+#define BDA_SETTING_LOCK_CMOS   0x08 // drivers/warmboot.asm locks again after a fast CPU reset
+
+struct bda_params {
+    uint8_t ide_multiple; // sectors per READ/WRITE MULTIPLE block, 0 = disabled
+    uint8_t ide_flags;    // BDA_IDE_* flags
+    uint16_t ide_cylinders; // IDENTIFY geometry, 0 = no drive
+    uint64_t ide_sectors; // total number of user addressable sectors
+    uint8_t ide_heads;
+    uint8_t ide_spt;
+    uint8_t ide_pio_mode; // PIO mode set with SET FEATURES
+    uint8_t post_flags;   // BDA_POST_* flags
+    uint16_t mem_total_kb; // memory size measured by the last full POST
+    uint8_t settings;     // BDA_SETTING_* flags, snapshot of the CMOS settings
+    uint32_t uptime_ticks; // timer ticks since the boot, counted by the assembly IRQ0
+    uint8_t tty_flags;    // INT 10h TTY state, assembly only
+    uint16_t tty_cursor;
+    uint16_t tty_offset;
+    uint16_t shadow_blocks; // 16 KB blocks of 0xC0000 - 0xFFFFF run from RAM (drivers/shadow.asm)
+} __attribute__((packed));
+
+extern volatile struct bda_params *bda;
+
+#endif
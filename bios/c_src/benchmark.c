@@ -0,0 +1,239 @@
+#include "benchmark.h"
+
+// F2 SYSTEM TEST, timed against the PIT with timeline_now()
+
+#define BENCH_BUFFER 0x100000 // tested extended RAM, 2 x 64 KB
+#define BENCH_ROM 0xF0000
+#define BENCH_ISA_READ 0xA0000
+#define BENCH_ISA_WRITE 0xBC000 // text pages 4-7, not on screen
+
+_Static_assert(sizeof(struct bench_results) <= 31 - CMOS_BENCH_OFFSET, "benchmark results do not fit CMOS");
+
+static const struct {
+    uint16_t port;
+    const char *name;
+} bench_ports[BENCH_IO_PORTS] = {
+    {0x21, "I/O read PIC 21h"},
+    {0x42, "I/O read PIT 42h"},
+    {0x71, "I/O read CMOS 71h"},
+    {0x64, "I/O read KBC 64h"},
+    {0x3DA, "I/O read VGA 3DAh (ISA)"}
+};
+
+static struct bench_results bench_now;
+static struct bench_results bench_saved;
+
+// Same CR0 bits as cache_enable in drivers/cache.asm
+static void cache_set(int enabled) {
+    uint32_t cr0;
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    if(enabled) {
+        cr0 &= 0x9FFFFFFF;
+    } else {
+        cr0 |= 0x60000000; // CD and NW
+    }
+    asm volatile("mov %0, %%cr0\n\twbinvd" : : "r"(cr0) : "memory");
+}
+
+static void bench_read(uint32_t addr, uint32_t dwords) {
+    asm volatile("rep lodsl" : "+S"(addr), "+c"(dwords) : : "eax", "memory");
+}
+
+static void bench_write(uint32_t addr, uint32_t dwords) {
+    asm volatile("rep stosl" : "+D"(addr), "+c"(dwords) : "a"(0) : "memory");
+}
+
+static void bench_copy(uint32_t dest, uint32_t src, uint32_t dwords) {
+    asm volatile("rep movsl" : "+D"(dest), "+S"(src), "+c"(dwords) : : "memory");
+}
+
+// MB/s x10 = KB * 1193180 * 10 / 1024 / clocks
+static uint16_t bench_rate(uint32_t kb, uint32_t clocks) {
+    if(clocks == 0) clocks = 1;
+    return kb * 11652 / clocks;
+}
+
+enum bench_op {
+    BENCH_READ,
+    BENCH_WRITE,
+    BENCH_COPY
+};
+
+static uint16_t bench_memory(enum bench_op op, uint32_t addr, uint32_t kb, int passes) {
+    uint32_t start = timeline_now();
+
+    for(int i=0; i<passes; i++) {
+        switch(op) {
+            case BENCH_READ:
+                bench_read(addr, kb * 256);
+                break;
+            case BENCH_WRITE:
+                bench_write(addr, kb * 256);
+                break;
+            case BENCH_COPY:
+                bench_copy(addr + kb * 1024, addr, kb * 256);
+                break;
+        }
+    }
+
+    return bench_rate(kb * passes, timeline_now() - start);
+}
+
+// 1000 reads, ns / 10 per read (838 ns per PIT clock)
+static uint8_t bench_io(uint16_t port) {
+    uint32_t start = timeline_now();
+    for(int i=0; i<1000; i++) { // even count keeps the PIT byte flip-flop in place
+        inb(port);
+    }
+    uint32_t ns = (timeline_now() - start) * 838 / 1000;
+    if(ns / 10 > 255) return 255;
+    return ns / 10;
+}
+
+// dec + jnz take 4 clocks per iteration on a 486, MHz x10
+static uint16_t bench_cpu() {
+    uint32_t count = 1000000;
+    uint32_t start = timeline_now();
+    asm volatile("1: dec %0\n\tjnz 1b" : "+r"(count));
+    uint32_t clocks = timeline_now() - start;
+    if(clocks == 0) clocks = 1;
+    return 47727200 / clocks; // 4000000 * 1193180 * 10 / 1000000
+}
+
+static uint16_t bench_ide() {
+    uint32_t start = timeline_now();
+    int sectors = 0;
+
+    for(int i=0; i<4; i++) {
+        sectors += IDE_read_sectors(i * 256, 0, (uint16_t*)BENCH_BUFFER);
+    }
+    if(sectors == 0) return 0;
+
+    return bench_rate(sectors / 2, timeline_now() - start);
+}
+
+static void bench_run(int ide_detected) {
+    memset(&bench_now, 0, sizeof(bench_now));
+
+    bench_now.cpu_mhz = bench_cpu();
+    bench_now.ram_cached[0] = bench_memory(BENCH_READ, BENCH_BUFFER, 64, 16);
+    bench_now.ram_cached[1] = bench_memory(BENCH_WRITE, BENCH_BUFFER, 64, 16);
+    bench_now.ram_cached[2] = bench_memory(BENCH_COPY, BENCH_BUFFER, 64, 16);
+
+    // bus speeds are measured with the cache off
+    cache_set(0);
+    bench_now.ram_uncached[0] = bench_memory(BENCH_READ, BENCH_BUFFER, 64, 4);
+    bench_now.ram_uncached[1] = bench_memory(BENCH_WRITE, BENCH_BUFFER, 64, 4);
+    bench_now.ram_uncached[2] = bench_memory(BENCH_COPY, BENCH_BUFFER, 64, 4);
+    bench_now.rom_read = bench_memory(BENCH_READ, BENCH_ROM, 64, 1);
+    bench_now.isa_read = bench_memory(BENCH_READ, BENCH_ISA_READ, 64, 1);
+    bench_now.isa_write = bench_memory(BENCH_WRITE, BENCH_ISA_WRITE, 16, 1);
+    for(int i=0; i<BENCH_IO_PORTS; i++) {
+        bench_now.io_latency[i] = bench_io(bench_ports[i].port);
+    }
+    cache_set(1);
+
+    if(ide_detected) bench_now.ide_read = bench_ide();
+}
+
+// value x10 -> "12.3"
+static void bench_print(uint16_t value, const char *unit, int x, int y) {
+    char buf[16];
+    char frac[4];
+
+    itoa(value / 10, buf, 10);
+    strcat(buf, ".");
+    strcat(buf, itoa(value % 10, frac, 10));
+    strcat(buf, unit);
+    vga_print_string("               ", x, y, 0x1F);
+    vga_print_string(buf, x, y, 0x1F);
+}
+
+static void bench_draw_column(struct bench_results *results, int x) {
+    char buf[16];
+
+    if(results->cpu_mhz == 0) { // nothing saved yet
+        vga_print_string("-", x, 4, 0x17);
+        return;
+    }
+
+    for(int i=0; i<3; i++) {
+        bench_print(results->ram_cached[i], " MB/s", x, 4 + i);
+        bench_print(results->ram_uncached[i], " MB/s", x, 7 + i);
+    }
+    bench_print(results->rom_read, " MB/s", x, 10);
+    bench_print(results->isa_read, " MB/s", x, 11);
+    bench_print(results->isa_write, " MB/s", x, 12);
+    bench_print(results->ide_read, " MB/s", x, 13);
+    bench_print(results->cpu_mhz, " MHz", x, 14);
+
+    for(int i=0; i<BENCH_IO_PORTS; i++) {
+        itoa(results->io_latency[i] * 10, buf, 10);
+        strcat(buf, " ns");
+        vga_print_string("               ", x, 15 + i, 0x1F);
+        vga_print_string(buf, x, 15 + i, 0x1F);
+    }
+}
+
+void benchmark_display(int ide_detected) {
+    static const char *labels[] = {
+        "RAM read (L1 on)",
+        "RAM write (L1 on)",
+        "RAM copy (L1 on)",
+        "RAM read (L1 off)",
+        "RAM write (L1 off)",
+        "RAM copy (L1 off)",
+        "ROM read (8-bit)",
+        "ISA memory read A0000h",
+        "ISA memory write BC000h",
+        "IDE sequential read",
+        "CPU clock (estimate)"
+    };
+
+    vga_clear(0x17);
+
+    vga_print_string("System Test", 34, 0, 0x07);
+    for(int x=0; x<80; x++) {
+        vga_set_char_attr(0x2F, x, 0);
+        vga_set_char_attr(0x0F, x, 24);
+        vga_print_char('=', x, 23, 0x1F);
+    }
+
+    vga_print_string("Test", 2, 2, 0x1F);
+    vga_print_string("Now", 36, 2, 0x1F);
+    vga_print_string("Saved", 56, 2, 0x1F);
+    for(int i=0; i<11; i++) {
+        vga_print_string(labels[i], 2, 4 + i, 0x17);
+    }
+    for(int i=0; i<BENCH_IO_PORTS; i++) {
+        vga_print_string(bench_ports[i].name, 2, 15 + i, 0x17);
+    }
+
+    cmos_get_block(CMOS_BENCH_OFFSET, &bench_saved, sizeof(bench_saved));
+    bench_draw_column(&bench_saved, 56);
+
+    vga_print_string("Running...", 36, 4, 0x1E);
+    vga_flush();
+    bench_run(ide_detected);
+    bench_draw_column(&bench_now, 36);
+
+    vga_print_string("[S SAVE AS BASELINE]  [ESC EXIT]", 24, 24, 0x0F);
+
+    kb_clear_buffer();
+
+    while(1) {
+        vga_flush();
+        if(kb_is_available()) {
+            uint8_t scancode = kb_get_scancode();
+            if(scancode==0x01) { // ESC
+                break;
+            }
+            if(scancode==0x1F) { // S
+                bench_saved = bench_now;
+                cmos_set_block(CMOS_BENCH_OFFSET, &bench_saved, sizeof(bench_saved));
+                cmos_save();
+                bench_draw_column(&bench_saved, 56);
+            }
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdint.h>
+#include "x86io.h"
+#include "utils.h"
+#include "vga.h"
+#include "interrupts.h"
+#include "cmos.h"
+#include "ide.h"
+#include "timeline.h"
+
+#define BENCH_IO_PORTS 5
+
+// Results are stored in CMOS as the comparison baseline, keep it 27 bytes
+struct bench_results {
+    uint16_t ram_cached[3];   // read, write, copy in MB/s x10, L1 on
+    uint16_t ram_uncached[3]; // L1 off
+    uint16_t rom_read;        // MB/s x10
+    uint16_t isa_read;
+    uint16_t isa_write;
+    uint16_t ide_read;
+    uint16_t cpu_mhz;         // MHz x10
+    uint8_t io_latency[BENCH_IO_PORTS]; // ns / 10
+} __attribute__((packed));
+
+void benchmark_display(int ide_detected);
+
+#endif
@@ -1,9 +1,20 @@
 #include "cmos.h"
+#include "bda.h"
 
 static uint8_t cmos_data[32];
 
 #define CMOS_BASE 0x40
 
+// Settings for the assembly BIOS, which doesn't read the CMOS at runtime
+static void cmos_publish() {
+    uint8_t settings = 0;
+    if(cmos_get(CMOS_LBA_ENABLED)) settings |= BDA_SETTING_LBA;
+    if(cmos_get(CMOS_DISK_CACHE)) settings |= BDA_SETTING_DISK_CACHE;
+    if(cmos_get(CMOS_FULL_POST)) settings |= BDA_SETTING_FULL_POST;
+    if(cmos_get(CMOS_LOCK_CMOS)) settings |= BDA_SETTING_LOCK_CMOS;
+    bda->settings = settings;
+}
+
 uint8_t cmos_read() {
     uint8_t cmos_checksum = 0;
     for(int i=0; i<31; i++) {
@@ -20,6 +31,7 @@ uint8_t cmos_read() {
         return 0;
     }
     
+    cmos_publish();
     return 1;
 }
 
@@ -33,6 +45,7 @@ void cmos_save() {
     }
     outb(0x70, CMOS_BASE + 0x1F);
     outb(0x71, cmos_checksum);
+    cmos_publish();
 }
 
 
@@ -51,6 +64,26 @@ uint8_t cmos_get(enum CMOS_SETTINGS setting) {
             if((cmos_data[0] & 0b00000100) > 0) return 1;
             return 0;
 
+        case CMOS_DISK_CACHE:
+            if((cmos_data[0] & 0b00001000) > 0) return 1;
+            return 0;
+
+        case CMOS_FULL_POST:
+            if((cmos_data[0] & 0b00010000) > 0) return 1;
+            return 0;
+
+        case CMOS_LINUX_BOOT:
+            if((cmos_data[0] & 0b00100000) > 0) return 1;
+            return 0;
+
+        case CMOS_NMI_PROFILER:
+            if((cmos_data[0] & 0b01000000) > 0) return 1;
+            return 0;
+
+        case CMOS_SHADOW_ROMS:
+            if((cmos_data[0] & 0b10000000) > 0) return 1;
+            return 0;
+
 
         default:
             return 0;
@@ -84,16 +117,70 @@ void cmos_set(enum CMOS_SETTINGS setting, uint8_t value) {
             }
             break;
 
+        case CMOS_DISK_CACHE:
+            if(value > 0) {
+                cmos_data[0] |=  0b00001000;
+            } else {
+                cmos_data[0] &= ~0b00001000;
+            }
+            break;
+
+        case CMOS_FULL_POST:
+            if(value > 0) {
+                cmos_data[0] |=  0b00010000;
+            } else {
+                cmos_data[0] &= ~0b00010000;
+            }
+            break;
+
+        case CMOS_LINUX_BOOT:
+            if(value > 0) {
+                cmos_data[0] |=  0b00100000;
+            } else {
+                cmos_data[0] &= ~0b00100000;
+            }
+            break;
+
+        case CMOS_NMI_PROFILER:
+            if(value > 0) {
+                cmos_data[0] |=  0b01000000;
+            } else {
+                cmos_data[0] &= ~0b01000000;
+            }
+            break;
+
+        case CMOS_SHADOW_ROMS:
+            if(value > 0) {
+                cmos_data[0] |=  0b10000000;
+            } else {
+                cmos_data[0] &= ~0b10000000;
+            }
+            break;
+
         default:
             break;
     }
 }
 
+void cmos_get_block(uint8_t offset, void *buf, int len) {
+    memcpy(buf, &cmos_data[offset], len);
+}
+
+void cmos_set_block(uint8_t offset, const void *buf, int len) {
+    memcpy(&cmos_data[offset], buf, len);
+}
+
 void cmos_lock() {
     outb(0x70, 0xFF);
     outb(0x71, 0x17);
 }
 
+// A warm boot does not reset the chipset, the profiler NMI may still run
+void cmos_nmi_timer_stop() {
+    outb(0x70, 0xF8);
+    outb(0x71, 0x00);
+}
+
 
 uint8_t cmos_is_m8sbc() {
     uint8_t b1, b2;
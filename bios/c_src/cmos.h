@@ -8,7 +8,12 @@
 enum CMOS_SETTINGS {
     CMOS_QUICK_MEMTEST,
     CMOS_LBA_ENABLED,
-    CMOS_LOCK_CMOS
+    CMOS_LOCK_CMOS,
+    CMOS_DISK_CACHE,
+    CMOS_FULL_POST,
+    CMOS_LINUX_BOOT,
+    CMOS_NMI_PROFILER,
+    CMOS_SHADOW_ROMS
 };
 
 uint8_t cmos_read(); // returns 0 if checksum was invalid
@@ -17,7 +22,13 @@ void cmos_save();
 uint8_t cmos_get(enum CMOS_SETTINGS setting);
 void cmos_set(enum CMOS_SETTINGS setting, uint8_t value);
 
+// Raw access to the 0x40-0x5E area, offset 0 = 0x40, cmos_save() writes it
+#define CMOS_BENCH_OFFSET 0x04 // 0x44 - 0x5E: benchmark baseline (benchmark.c)
+void cmos_get_block(uint8_t offset, void *buf, int len);
+void cmos_set_block(uint8_t offset, const void *buf, int len);
+
 void cmos_lock();
+void cmos_nmi_timer_stop();
 
 uint8_t cmos_is_m8sbc();
 uint16_t cmos_chp_version();
@@ -0,0 +1,34 @@
+#include "ebda.h"
+#include "utils.h"
+
+volatile struct ebda *ebda;
+volatile uint16_t *bda_ebda_segment = (uint16_t*)0x40E;
+volatile uint16_t *bda_lowram_size = (uint16_t*)0x413;
+
+void ebda_init(int disk_cache, int profiler) {
+    uint16_t size = sizeof(struct ebda);
+    if(disk_cache) size += EBDA_DCACHE_READAHEAD * 512;
+    uint16_t ring = size;
+    if(profiler) size += EBDA_PROFILE_ENTRIES * 4;
+
+    uint16_t size_kb = (size + 1023) / 1024;
+    uint16_t lowram = *bda_lowram_size - size_kb;
+
+    ebda = (struct ebda*)((uint32_t)lowram * 1024);
+    memset((void*)ebda, 0, size_kb * 1024);
+    ebda->size_kb = size_kb;
+    timeline_move(&ebda->timeline);
+
+    if(disk_cache) {
+        memset((void*)ebda->dcache_tags, 0xFF, sizeof(ebda->dcache_tags));
+        ebda->dcache_enabled = 1;
+    }
+
+    if(profiler) {
+        ebda->profile.entries = EBDA_PROFILE_ENTRIES;
+        ebda->profile.ring = ring;
+    }
+
+    *bda_lowram_size = lowram;
+    *bda_ebda_segment = lowram * 64;
+}
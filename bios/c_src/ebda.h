@@ -0,0 +1,104 @@
+#ifndef EBDA_H
+#define EBDA_H
+
+#include <stdint.h>
+#include "timeline.h"
+
+// Extended BIOS Data Area, placed at the top of conventional memory
+// Layout must match data/ebda.asm
+
+#define EBDA_DCACHE_SETS 64
+#define EBDA_DCACHE_WAYS 4
+#define EBDA_DCACHE_READAHEAD 8 // sectors, size of the read-ahead buffer
+#define EBDA_DCACHE_BASE 0x4A0000 // DCACHE_BASE in config.inc
+
+#define EBDA_MEMMAP_ENTRIES 8
+
+#define EBDA_SERIAL_PORTS 2
+#define EBDA_SERIAL_RX_SIZE 1024
+#define EBDA_SERIAL_TX_SIZE 256
+
+#define EBDA_PROFILE_ENTRIES 1024
+
+struct fdpt {
+    uint16_t cylinders;
+    uint8_t heads;
+    uint16_t reduced_write;
+    uint16_t precomp;
+    uint8_t ecc_burst;
+    uint8_t control;        // bit 3: more than 8 heads
+    uint8_t std_timeout;
+    uint8_t fmt_timeout;
+    uint8_t chk_timeout;
+    uint16_t landing_zone;
+    uint8_t spt;
+    uint8_t reserved;
+} __attribute__((packed));
+
+struct e820_entry {
+    uint64_t base;
+    uint64_t length;
+    uint32_t type;          // E820_RAM, E820_RESERVED
+} __attribute__((packed));
+
+struct ebda_serial {
+    uint16_t base;          // 0 = not set up by INT 14h, polled
+    uint8_t flags;          // bit 0: 16550A FIFO enabled
+    uint8_t lsr;            // line errors seen by the IRQ
+    uint16_t rx_head;
+    uint16_t rx_tail;
+    uint16_t tx_head;
+    uint16_t tx_tail;
+    uint32_t reserved;
+    uint8_t rx[EBDA_SERIAL_RX_SIZE];
+    uint8_t tx[EBDA_SERIAL_TX_SIZE];
+} __attribute__((packed));
+
+struct ebda_profile {
+    uint16_t head;          // advanced by the NMI handler
+    uint16_t tail;          // advanced by the reader
+    uint32_t dropped;       // samples lost while the ring was full
+    uint32_t count;
+    uint16_t entries;       // 0 = profiler not available
+    uint16_t ring;          // EBDA offset of the ring, entries are IP, CS
+    uint8_t active;         // 1 while sampling
+    uint8_t reserved[15];
+} __attribute__((packed));
+
+struct ebda {
+    uint8_t size_kb;        // EBDA size in KB
+    uint8_t reserved0[15];
+
+    // disk cache (drivers/diskcache.asm)
+    uint8_t dcache_enabled;
+    uint8_t reserved1[3];
+    uint32_t dcache_hits;
+    uint32_t dcache_misses;
+    uint32_t reserved2;
+    uint8_t dcache_next[EBDA_DCACHE_SETS];
+    uint32_t dcache_tags[EBDA_DCACHE_SETS * EBDA_DCACHE_WAYS]; // 0xFFFFFFFF = empty
+
+    struct fdpt fdpt;       // INT 41h fixed disk parameter table
+    struct timeline timeline; // POST timeline, moved here from TIMELINE_EARLY_ADDR
+
+    // INT 15h memory map (memmap.c)
+    uint8_t memmap_count;
+    uint8_t reserved3;
+    uint16_t ext_kb;        // tested KB from 1 MB up
+    uint32_t reserved4[3];
+    struct e820_entry memmap[EBDA_MEMMAP_ENTRIES];
+
+    // COM1/COM2 ring buffers (drivers/serial.asm)
+    struct ebda_serial serial[EBDA_SERIAL_PORTS];
+
+    // NMI sampling profiler (drivers/profiler.asm)
+    struct ebda_profile profile;
+} __attribute__((packed));
+// followed by the read-ahead buffer while the disk cache is enabled,
+// then by the profiler ring while it is enabled
+
+extern volatile struct ebda *ebda;
+
+void ebda_init(int disk_cache, int profiler);
+
+#endif
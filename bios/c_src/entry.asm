@@ -11,7 +11,10 @@ global gdt_descriptor
 global preparing_for_real_mode
 
 extern main
-extern _data_load_addr
+extern _text_load_addr
+extern _text_start
+extern _image_end
+extern _data_unpacked
 extern _data_start
 extern _data_end
 extern _bss_start
@@ -68,19 +71,29 @@ protected_mode_start:
     mov ss, ax
     mov esp, 0x900 ; ASM stack is at 0x1000
 
-    ; 5. Copy Data (ROM -> RAM)
-    mov esi, _data_load_addr
+    ; 5. Unpack Code and Data (ROM -> RAM)
+    ; Both are LZ4 packed right after this entry code, see lz4pack.py
+    cld
+    mov esi, _text_load_addr
+    mov edi, _text_start
+    mov ebx, _image_end
+    call lz4_unpack
+
+    ; Data was unpacked behind the code, move it to its place
+    mov esi, _data_unpacked
     mov edi, _data_start
     mov ecx, _data_end
     sub ecx, _data_start
-    rep movsb
+    shr ecx, 2
+    rep movsd
 
     ; 6. Clear BSS
     mov edi, _bss_start
     mov ecx, _bss_end
     sub ecx, _bss_start
+    shr ecx, 2
     xor eax, eax
-    rep stosb
+    rep stosd
 
     ; 7. Call C
     call main
@@ -88,6 +101,48 @@ protected_mode_start:
     ; 8. Return to Real Mode
     jmp 0x18:_off_prep_rm
 
+; lz4_unpack
+; Unpacks an LZ4 block format stream
+; In:
+;   ESI - packed stream
+;   EDI - destination
+;   EBX - destination end, the stream ends with its last literals
+lz4_unpack:
+    xor eax, eax
+    lodsb
+    mov edx, eax ; token: literal length << 4 | match length - 4
+    shr eax, 4
+    call .length
+    mov ecx, eax
+    rep movsb
+    cmp edi, ebx
+    jae .done
+
+    xor eax, eax
+    lodsw ; match offset
+    push esi
+    mov esi, edi
+    sub esi, eax
+    mov eax, edx
+    and eax, 0x0F
+    call .length
+    lea ecx, [eax + 4]
+    rep movsb ; byte copy, the match may overlap its own output
+    pop esi
+    jmp lz4_unpack
+
+.length: ; lengths of 15 continue in the following bytes
+    cmp eax, 15
+    jne .done
+.length_next:
+    movzx ecx, byte [esi]
+    inc esi
+    add eax, ecx
+    cmp ecx, 255
+    je .length_next
+.done:
+    ret
+
 bits 16
 preparing_for_real_mode:
     mov ax, 0x20 
@@ -144,7 +199,8 @@ gdt_descriptor:
 
 
 ; ---------------------------------------------
-; Extra: C helpers
+; Extra: C helpers, run from RAM with the C code
+section .text
 bits 32
 isr_irq0:
     pusha
@@ -2,26 +2,6 @@
 
 static uint16_t disk_data[256];
 
-void IDE_reset() {
-    outb(IDE_DEV_CONTROL, 0b00000100);
-    uint32_t start_ticks = irq0_ticks;
-
-    while(1) {
-        if(irq0_ticks > start_ticks+2) break;
-        asm volatile("nop");
-        io_wait();
-    }
-
-    outb(IDE_DEV_CONTROL, 0b00000000);
-
-    start_ticks = irq0_ticks;
-    while(1) {
-        if(irq0_ticks > start_ticks+2) break;
-        asm volatile("nop");
-        io_wait();
-    }
-}
-
 int IDE_wait_busy(int timeout) {
     uint32_t start_ticks = irq0_ticks;
     while(1) {
@@ -34,34 +14,8 @@ int IDE_wait_busy(int timeout) {
     return 1;
 }
 
-int IDE_detect(char *drive_name) {
-    outb(IDE_NUM3, 0xA0); // select master drive
-    io_wait();
-    outb(IDE_COMMAND, 0xEC); // IDENTIFY command
-    io_wait();
-
-    memset(drive_name, 0, 41);
-
-    uint32_t irq0_start = irq0_ticks;
-
-    while(1) {
-        io_wait();
-        uint8_t status = inb(IDE_STATUS);
-
-        uint32_t elapsed = irq0_ticks - irq0_start;
-        if(elapsed > 500) return 0; // 5 seconds
-
-        static uint32_t last_ticks = 0;
-        if(last_ticks!=irq0_ticks) { // to not redraw every few cpu cycles
-            vga_print_itoa(elapsed / 100, 20+13, 12, 0x07, 10, 0);
-            last_ticks = irq0_ticks;
-        }
-
-        if(!(status & 0x80) && (status & 8)) {
-            break;
-        }
-    }
-
+// IDENTIFY data is ready, read and check it
+static int IDE_read_identify(char *drive_name) {
     for(int i=0;i<256;i++) {
         disk_data[i] = inw(IDE_DATA);
         io_wait();
@@ -93,3 +47,217 @@ int IDE_detect(char *drive_name) {
 
     return check;
 }
+
+enum IDE_probe_state {
+    IDE_PROBE_RESET,        // SRST asserted
+    IDE_PROBE_RELEASE,      // SRST released, wait before polling
+    IDE_PROBE_SPINUP,       // wait for BSY to clear
+    IDE_PROBE_IDENTIFY,     // wait for IDENTIFY data
+    IDE_PROBE_DONE
+};
+
+static volatile enum IDE_probe_state probe_state = IDE_PROBE_DONE;
+static volatile uint32_t probe_ticks; // ticks spent in the current state
+static volatile uint32_t probe_total;
+static volatile int probe_detected;
+static char *probe_name;
+
+static void IDE_probe_next(enum IDE_probe_state state) {
+    probe_state = state;
+    probe_ticks = 0;
+}
+
+void IDE_probe_start(char *drive_name) {
+    probe_name = drive_name;
+    memset(drive_name, 0, 41);
+    probe_detected = 0;
+    probe_total = 0;
+    IDE_probe_next(IDE_PROBE_RESET);
+}
+
+int IDE_probe_step() {
+    uint8_t status;
+
+    probe_ticks++;
+    probe_total++;
+
+    switch(probe_state) {
+        case IDE_PROBE_RESET:
+            outb(IDE_DEV_CONTROL, 0b00000100);
+            IDE_probe_next(IDE_PROBE_RELEASE);
+            break;
+
+        case IDE_PROBE_RELEASE:
+            if(probe_ticks > 2) {
+                outb(IDE_DEV_CONTROL, 0b00000000);
+                IDE_probe_next(IDE_PROBE_SPINUP);
+            }
+            break;
+
+        case IDE_PROBE_SPINUP:
+            if(probe_ticks <= 2) break;
+            if(!(inb(IDE_STATUS) & 0x80)) {
+                outb(IDE_NUM3, 0xA0); // select master drive
+                io_wait();
+                outb(IDE_COMMAND, IDE_CMD_IDENTIFY);
+                io_wait();
+                IDE_probe_next(IDE_PROBE_IDENTIFY);
+            } else if(probe_ticks > 500) { // 5 seconds
+                IDE_probe_next(IDE_PROBE_DONE);
+            }
+            break;
+
+        case IDE_PROBE_IDENTIFY:
+            status = inb(IDE_STATUS);
+            if(!(status & 0x80) && (status & 8)) {
+                probe_detected = IDE_read_identify(probe_name);
+                IDE_probe_next(IDE_PROBE_DONE);
+            } else if(probe_ticks > 500) { // 5 seconds
+                IDE_probe_next(IDE_PROBE_DONE);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return probe_state == IDE_PROBE_DONE;
+}
+
+uint32_t IDE_probe_elapsed() {
+    return probe_total;
+}
+
+int IDE_probe_result() {
+    return probe_detected;
+}
+
+int IDE_set_multiple() {
+    // IDENTIFY word 47, bits 7-0: max sectors per READ/WRITE MULTIPLE block
+    uint8_t count = disk_data[47] & 0xFF;
+
+    bda->ide_multiple = 0; // int 13h falls back to single sector commands
+
+    if(count < 2) return 0;
+
+    outb(IDE_NUM3, 0xA0); // select master drive
+    io_wait();
+    outb(IDE_SEC_COUNT, count);
+    io_wait();
+    outb(IDE_COMMAND, IDE_CMD_SET_MULTIPLE);
+    io_wait();
+
+    if(!IDE_wait_busy(100)) return 0;
+    if(inb(IDE_STATUS) & 0x01) return 0; // ERR, block size rejected
+
+    bda->ide_multiple = count;
+    return count;
+}
+
+void IDE_store_params() {
+    uint8_t flags = 0;
+    uint64_t sectors;
+
+    // IDENTIFY word 49 bit 9: LBA supported
+    if(disk_data[49] & (1 << 9)) flags |= BDA_IDE_LBA;
+    // IDENTIFY word 83 bit 10: 48-bit address feature set (bits 15-14 = 01 when valid)
+    if((disk_data[83] & 0xC000) == 0x4000 && (disk_data[83] & (1 << 10))) flags |= BDA_IDE_LBA48;
+
+    if(flags & BDA_IDE_LBA48) {
+        // words 100-103: max user LBA for 48-bit commands
+        sectors = disk_data[100] | ((uint32_t)disk_data[101] << 16) |
+            ((uint64_t)disk_data[102] << 32) | ((uint64_t)disk_data[103] << 48);
+    } else {
+        // words 60-61: user addressable sectors for 28-bit commands
+        sectors = disk_data[60] | ((uint32_t)disk_data[61] << 16);
+    }
+
+    // IDENTIFY word 49 bit 11: IORDY supported
+    if(disk_data[49] & (1 << 11)) flags |= BDA_IDE_IORDY;
+
+    bda->ide_flags = flags;
+    bda->ide_sectors = sectors;
+
+    // default geometry, words 1, 3 and 6
+    bda->ide_cylinders = disk_data[1];
+    bda->ide_heads = disk_data[3];
+    bda->ide_spt = disk_data[6];
+}
+
+int IDE_set_pio_mode() {
+    // IDENTIFY word 51 bits 15-8: highest PIO mode 0-2
+    uint8_t mode = disk_data[51] >> 8;
+    if(mode > 2) mode = 0;
+
+    // word 53 bit 1: word 64 valid, bits 0/1: PIO mode 3/4 supported
+    // modes 3 and 4 need IORDY flow control
+    if((disk_data[53] & 0x02) && (bda->ide_flags & BDA_IDE_IORDY)) {
+        if(disk_data[64] & 0x02) mode = 4;
+        else if(disk_data[64] & 0x01) mode = 3;
+    }
+
+    outb(IDE_NUM3, 0xA0); // select master drive
+    io_wait();
+    outb(IDE_FEATURES, IDE_FEATURE_TRANSFER_MODE);
+    io_wait();
+    outb(IDE_SEC_COUNT, 0x08 | mode); // PIO flow control transfer mode
+    io_wait();
+    outb(IDE_COMMAND, IDE_CMD_SET_FEATURES);
+    io_wait();
+
+    bda->ide_pio_mode = 0;
+
+    if(!IDE_wait_busy(100)) return 0;
+    if(inb(IDE_STATUS) & 0x01) return 0; // ERR, mode rejected, drive keeps its default
+
+    bda->ide_pio_mode = mode;
+    return mode;
+}
+
+volatile uint32_t *ivt_int41 = (uint32_t*)(0x41 * 4);
+
+void IDE_build_fdpt() {
+    // INT 41h table with the geometry reported by int 13h (at most 1024 cylinders)
+    volatile struct fdpt *fdpt = &ebda->fdpt;
+    uint16_t cylinders = bda->ide_cylinders;
+    if(cylinders > 1024) cylinders = 1024;
+
+    fdpt->cylinders = cylinders;
+    fdpt->heads = bda->ide_heads;
+    fdpt->precomp = 0xFFFF; // none
+    fdpt->control = (bda->ide_heads > 8) ? 0x08 : 0x00;
+    fdpt->landing_zone = cylinders;
+    fdpt->spt = bda->ide_spt;
+
+    *ivt_int41 = ((uint32_t)(((uint32_t)ebda) >> 4) << 16) + __builtin_offsetof(struct ebda, fdpt);
+}
+
+// BSY clear and DRQ set, no error
+static int IDE_wait_data() {
+    if(!IDE_wait_busy(100)) return 0;
+    uint8_t status = inb(IDE_STATUS);
+    if(status & 0x01) return 0;
+    return (status & 0x08) ? 1 : 0;
+}
+
+// READ SECTORS, count 0 = 256, returns the number of sectors read
+int IDE_read_sectors(uint32_t lba, uint8_t count, uint16_t *buffer) {
+    if(!(bda->ide_flags & BDA_IDE_LBA)) return 0;
+
+    outb(IDE_NUM3, 0xE0 | ((lba >> 24) & 0x0F)); // master, LBA
+    io_wait();
+    outb(IDE_SEC_COUNT, count);
+    outb(IDE_NUM0, lba & 0xFF);
+    outb(IDE_NUM1, (lba >> 8) & 0xFF);
+    outb(IDE_NUM2, (lba >> 16) & 0xFF);
+    outb(IDE_COMMAND, IDE_CMD_READ_SECTORS);
+    io_wait();
+
+    int sectors = count ? count : 256;
+    for(int i=0; i<sectors; i++) {
+        if(!IDE_wait_data()) return i;
+        uint32_t words = 256;
+        asm volatile("rep insw" : "+D"(buffer), "+c"(words) : "d"(IDE_DATA) : "memory");
+    }
+    return sectors;
+}
@@ -6,8 +6,11 @@
 #include "utils.h"
 #include "vga.h"
 #include "interrupts.h"
+#include "bda.h"
+#include "ebda.h"
 
 #define IDE_DATA 0x1F0
+#define IDE_FEATURES 0x1F1
 #define IDE_SEC_COUNT 0x1F2
 #define IDE_NUM0 0x1F3
 #define IDE_NUM1 0x1F4
@@ -18,8 +21,26 @@
 
 #define IDE_DEV_CONTROL 0x3F6
 
-void IDE_reset();
+#define IDE_CMD_READ_SECTORS 0x20
+#define IDE_CMD_IDENTIFY 0xEC
+#define IDE_CMD_SET_MULTIPLE 0xC6
+#define IDE_CMD_SET_FEATURES 0xEF
+
+#define IDE_FEATURE_TRANSFER_MODE 0x03
+
 int IDE_wait_busy(int timeout);
-int IDE_detect(char *drive_name);
+
+// Drive reset and IDENTIFY, stepped every timer tick (see post.c)
+void IDE_probe_start(char *drive_name);
+int IDE_probe_step();
+uint32_t IDE_probe_elapsed();
+int IDE_probe_result();
+
+int IDE_set_multiple();
+void IDE_store_params();
+int IDE_set_pio_mode();
+void IDE_build_fdpt();
+
+int IDE_read_sectors(uint32_t lba, uint8_t count, uint16_t *buffer); // LBA drives only
 
 #endif
\ No newline at end of file
@@ -70,13 +70,21 @@ void idt_restore_real_mode(void) {
 void pit_set_int_freq(uint32_t freq) {
     // Configure PIT
     uint32_t divisor = 1193180 / freq;
-    outb(0x43, 0x36); // Command port
+    outb(0x43, 0x34); // Command port, mode 2 so a latched count is linear (timeline.c)
     outb(0x40, divisor & 0xFF); // Low byte
     outb(0x40, (divisor >> 8) & 0xFF); // High byte
 }
 
 ////// interrupt handlers
 
+static irq0_callback_ptr irq0_stored_callback = 0;
+
+irq0_callback_ptr irq0_register_callback(irq0_callback_ptr func) {
+    irq0_callback_ptr previous = irq0_stored_callback;
+    irq0_stored_callback = func;
+    return previous;
+}
+
 static irq1_callback_ptr irq1_stored_callback = 0;
 
 void irq1_register_callback(irq1_callback_ptr func) {
@@ -88,6 +96,10 @@ uint32_t irq0_ticks = 0;
 
 void c_isr_irq0() { // Timer tick
     irq0_ticks++;
+
+    if (irq0_stored_callback != NULL) {
+        irq0_stored_callback();
+    }
 }
 
 #define KB_BUF_SIZE 8
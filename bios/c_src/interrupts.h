@@ -21,6 +21,15 @@ static inline void sti() {
 static inline void cli() {
 	asm volatile ("cli");
 }
+// cli, returns the previous EFLAGS for irq_restore
+static inline uint32_t irq_save() {
+	uint32_t flags;
+	asm volatile ("pushf\n\tpop %0\n\tcli" : "=r"(flags) : : "memory");
+	return flags;
+}
+static inline void irq_restore(uint32_t flags) {
+	asm volatile ("push %0\n\tpopf" : : "r"(flags) : "memory", "cc");
+}
 static inline void pic_set_mask(uint8_t mask) {
     outb(0x21, mask);
 }
@@ -31,6 +40,9 @@ void pit_set_int_freq(uint32_t freq);
 void c_isr_irq0();
 void c_isr_irq1();
 
+typedef void (*irq0_callback_ptr)(void);
+irq0_callback_ptr irq0_register_callback(irq0_callback_ptr func); // returns the replaced callback
+
 typedef void (*irq1_callback_ptr)(void);
 void irq1_register_callback(irq1_callback_ptr func);
 
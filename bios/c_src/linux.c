@@ -0,0 +1,101 @@
+#include "linux.h"
+
+// Reads straight to the load address, 256 sectors per command
+static int linux_read(uint32_t lba, uint32_t sectors, uint32_t addr) {
+    while(sectors) {
+        uint32_t count = (sectors > 256) ? 256 : sectors;
+        if(IDE_read_sectors(lba, (uint8_t)count, (uint16_t*)addr) != (int)count) return 0;
+        lba += count;
+        addr += count * 512;
+        sectors -= count;
+    }
+    return 1;
+}
+
+// First two partitions of LINUX_PART_TYPE, returns how many were found
+static int linux_find_partitions(volatile struct mbr_partition *found) {
+    volatile uint8_t *mbr = (uint8_t*)LINUX_SETUP_ADDR; // overwritten by the kernel later
+    volatile struct mbr_partition *table = (struct mbr_partition*)(LINUX_SETUP_ADDR + 0x1BE);
+    int count = 0;
+
+    if(!linux_read(0, 1, LINUX_SETUP_ADDR)) return 0;
+    if(mbr[510] != 0x55 || mbr[511] != 0xAA) return 0;
+
+    for(int i=0; i<4 && count<2; i++) {
+        if(table[i].type == LINUX_PART_TYPE && table[i].sectors) {
+            found[count++] = table[i];
+        }
+    }
+    return count;
+}
+
+enum linux_result linux_load() {
+    struct mbr_partition parts[2];
+    volatile struct linux_header *hdr = (struct linux_header*)(LINUX_SETUP_ADDR + 0x1F1);
+    uint32_t ram_end = LINUX_BZIMAGE_ADDR + ebda->ext_kb * 1024UL; // tested, contiguous
+
+    bda->post_flags &= ~BDA_POST_LINUX;
+
+    int found = linux_find_partitions(parts);
+    if(!found) return LINUX_NO_PARTITION;
+
+    // boot sector and the first setup sector, the header spans both
+    if(!linux_read(parts[0].lba, 2, LINUX_SETUP_ADDR)) return LINUX_READ_ERROR;
+    if(hdr->boot_flag != 0xAA55) return LINUX_BAD_IMAGE;
+
+    uint16_t version = (hdr->header == LINUX_HDRS) ? hdr->version : 0;
+    uint32_t setup_sects = hdr->setup_sects ? hdr->setup_sects : 4;
+    uint32_t syssize = (version >= 0x204) ? hdr->syssize : (hdr->syssize & 0xFFFF);
+    uint32_t kernel_sectors = (syssize * 16 + 511) / 512;
+    uint32_t kernel_addr = LINUX_ZIMAGE_ADDR;
+    uint32_t kernel_end = LINUX_SETUP_ADDR;
+    if(version >= 0x200 && (hdr->loadflags & LINUX_LOADED_HIGH)) {
+        kernel_addr = LINUX_BZIMAGE_ADDR;
+        kernel_end = ram_end;
+    }
+
+    if(1 + setup_sects + kernel_sectors > parts[0].sectors) return LINUX_BAD_IMAGE;
+    if((1 + setup_sects) * 512 > LINUX_HEAP_END - 0x200) return LINUX_TOO_BIG;
+    if(kernel_addr + kernel_sectors * 512 > kernel_end) return LINUX_TOO_BIG;
+    if((uint32_t)ebda < LINUX_SETUP_ADDR + LINUX_CMDLINE + LINUX_CMDLINE_SIZE) return LINUX_TOO_BIG;
+
+    if(!linux_read(parts[0].lba + 2, setup_sects - 1, LINUX_SETUP_ADDR + 1024)) return LINUX_READ_ERROR;
+    if(!linux_read(parts[0].lba + 1 + setup_sects, kernel_sectors, kernel_addr)) return LINUX_READ_ERROR;
+
+    if(version >= 0x200) {
+        hdr->type_of_loader = LINUX_LOADER_UNKNOWN;
+
+        if(found > 1) { // initrd at the top of the tested extended RAM
+            uint32_t size = parts[1].sectors * 512;
+            uint32_t top = ram_end;
+            if(version >= 0x203 && hdr->initrd_addr_max < top - 1) top = hdr->initrd_addr_max + 1;
+            uint32_t addr = (top - size) & ~0xFFFUL;
+            if(size > top || addr < LINUX_BZIMAGE_ADDR) return LINUX_TOO_BIG;
+            if(addr < kernel_addr + kernel_sectors * 512) return LINUX_TOO_BIG;
+
+            if(!linux_read(parts[1].lba, parts[1].sectors, addr)) return LINUX_READ_ERROR;
+            hdr->ramdisk_image = addr;
+            hdr->ramdisk_size = size;
+        }
+    }
+    if(version >= 0x201) {
+        hdr->heap_end_ptr = LINUX_HEAP_END - 0x200;
+        hdr->loadflags |= LINUX_CAN_USE_HEAP;
+    }
+
+    // Empty command line after the stack, the kernel takes whatever it finds
+    memset((void*)(LINUX_SETUP_ADDR + LINUX_CMDLINE), 0, LINUX_CMDLINE_SIZE);
+    if(version >= 0x202) {
+        hdr->cmd_line_ptr = LINUX_SETUP_ADDR + LINUX_CMDLINE;
+    } else {
+        *(volatile uint16_t*)(LINUX_SETUP_ADDR + 0x020) = LINUX_CMDLINE_MAGIC; // cmd_line_magic
+        *(volatile uint16_t*)(LINUX_SETUP_ADDR + 0x022) = LINUX_CMDLINE; // cmd_line_offset
+    }
+
+    // Zero page memory size from the memory test, setup refreshes it with INT 15h
+    *(volatile uint16_t*)(LINUX_SETUP_ADDR + 0x002) = ebda->ext_kb; // ext_mem_k
+    *(volatile uint32_t*)(LINUX_SETUP_ADDR + 0x1E0) = ebda->ext_kb; // alt_mem_k
+
+    bda->post_flags |= BDA_POST_LINUX;
+    return LINUX_LOADED;
+}
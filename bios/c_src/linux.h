@@ -0,0 +1,77 @@
+#ifndef LINUX_H
+#define LINUX_H
+
+#include <stdint.h>
+#include "ide.h"
+#include "bda.h"
+#include "ebda.h"
+
+// Linux kernel loader, see Documentation/i386/boot.txt in the kernel sources
+// The kernel (zImage or bzImage, written raw with dd) is the first MBR
+// partition of type LINUX_PART_TYPE, an initrd the second one
+
+#define LINUX_PART_TYPE 0xDA        // "non-FS data"
+
+#define LINUX_SETUP_ADDR 0x90000    // real-mode kernel, bios.asm jumps to 0x9020:0
+#define LINUX_HEAP_END 0x9800       // stack top, offset from LINUX_SETUP_ADDR
+#define LINUX_CMDLINE 0x9800        // command line, offset from LINUX_SETUP_ADDR
+#define LINUX_CMDLINE_SIZE 0x100
+#define LINUX_ZIMAGE_ADDR 0x10000
+#define LINUX_BZIMAGE_ADDR 0x100000
+
+#define LINUX_HDRS 0x53726448       // "HdrS"
+#define LINUX_LOADED_HIGH 0x01      // loadflags
+#define LINUX_CAN_USE_HEAP 0x80
+#define LINUX_LOADER_UNKNOWN 0xFF   // type_of_loader
+#define LINUX_CMDLINE_MAGIC 0xA33F  // at 0x20 before protocol 2.02
+
+enum linux_result {
+    LINUX_LOADED,
+    LINUX_NO_PARTITION,
+    LINUX_READ_ERROR,
+    LINUX_BAD_IMAGE,
+    LINUX_TOO_BIG
+};
+
+// Real-mode kernel header at LINUX_SETUP_ADDR + 0x1F1
+struct linux_header {
+    uint8_t setup_sects;        // 0 = 4
+    uint16_t root_flags;
+    uint32_t syssize;           // 16-byte units, 16 bits before protocol 2.04
+    uint16_t ram_size;
+    uint16_t vid_mode;
+    uint16_t root_dev;
+    uint16_t boot_flag;         // 0xAA55
+    uint16_t jump;
+    uint32_t header;            // LINUX_HDRS from protocol 2.00
+    uint16_t version;
+    uint32_t realmode_swtch;
+    uint16_t start_sys_seg;
+    uint16_t kernel_version;
+    uint8_t type_of_loader;
+    uint8_t loadflags;
+    uint16_t setup_move_size;
+    uint32_t code32_start;
+    uint32_t ramdisk_image;
+    uint32_t ramdisk_size;
+    uint32_t bootsect_kludge;
+    uint16_t heap_end_ptr;      // 2.01+
+    uint8_t ext_loader_ver;
+    uint8_t ext_loader_type;
+    uint32_t cmd_line_ptr;      // 2.02+
+    uint32_t initrd_addr_max;   // 2.03+
+} __attribute__((packed));
+
+struct mbr_partition {
+    uint8_t status;
+    uint8_t chs_first[3];
+    uint8_t type;
+    uint8_t chs_last[3];
+    uint32_t lba;
+    uint32_t sectors;
+} __attribute__((packed));
+
+// Loads the kernel and sets BDA_POST_LINUX, call after ebda_init() and memmap_build()
+enum linux_result linux_load();
+
+#endif
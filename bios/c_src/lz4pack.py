@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+# lz4pack.py
+# Input: raw binary (C code + data image, see linkerc.ld)
+# Output: LZ4 block format stream, unpacked by lz4_unpack in entry.asm
+# Greedy hash chain matcher, no external modules needed
+
+import sys
+
+# ----- Configuration -----
+MIN_MATCH = 4
+MAX_OFFSET = 0xFFFF
+CHAIN_DEPTH = 64
+LAST_LITERALS = 5     # LZ4 block rules: stream ends with literals only
+MF_LIMIT = 12         # and the last match starts before this point
+# --------------------------------
+
+def put_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+def put_sequence(out, literals, offset, match_len):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if offset:
+        token |= min(match_len - MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        put_length(out, lit_len - 15)
+    out += literals
+    if offset:
+        out += offset.to_bytes(2, "little")
+        if match_len - MIN_MATCH >= 15:
+            put_length(out, match_len - MIN_MATCH - 15)
+
+def compress(data):
+    out = bytearray()
+    size = len(data)
+    heads = {}
+    chain = [-1] * size
+    anchor = 0
+    pos = 0
+
+    def insert(p):
+        key = data[p:p + MIN_MATCH]
+        chain[p] = heads.get(key, -1)
+        heads[key] = p
+
+    while pos + MF_LIMIT < size:
+        best_len = 0
+        best_pos = -1
+        cand = heads.get(data[pos:pos + MIN_MATCH], -1)
+        depth = CHAIN_DEPTH
+        while cand >= 0 and pos - cand <= MAX_OFFSET and depth > 0:
+            n = 0
+            limit = size - LAST_LITERALS - pos
+            while n < limit and data[cand + n] == data[pos + n]:
+                n += 1
+            if n > best_len:
+                best_len = n
+                best_pos = cand
+            cand = chain[cand]
+            depth -= 1
+
+        if best_len < MIN_MATCH:
+            insert(pos)
+            pos += 1
+            continue
+
+        put_sequence(out, data[anchor:pos], pos - best_pos, best_len)
+        for p in range(pos, min(pos + best_len, size - MIN_MATCH)):
+            insert(p)
+        pos += best_len
+        anchor = pos
+
+    put_sequence(out, data[anchor:], 0, 0)
+    return out
+
+def decompress(packed, size):
+    # Mirrors lz4_unpack in entry.asm, used to verify the output
+    out = bytearray()
+    i = 0
+    while True:
+        token = packed[i]; i += 1
+        n = token >> 4
+        if n == 15:
+            while True:
+                b = packed[i]; i += 1
+                n += b
+                if b != 255: break
+        out += packed[i:i + n]; i += n
+        if len(out) >= size:
+            return bytes(out)
+        offset = packed[i] | (packed[i + 1] << 8); i += 2
+        n = token & 15
+        if n == 15:
+            while True:
+                b = packed[i]; i += 1
+                n += b
+                if b != 255: break
+        for _ in range(n + MIN_MATCH):
+            out.append(out[-offset])
+
+def main():
+    if len(sys.argv) != 3:
+        print("Usage: lz4pack.py <input.bin> <output.lz4>")
+        sys.exit(1)
+
+    data = open(sys.argv[1], "rb").read()
+    packed = compress(data)
+    if decompress(packed, len(data)) != data:
+        print("lz4pack.py: verification failed")
+        sys.exit(1)
+
+    open(sys.argv[2], "wb").write(packed)
+    print(f"lz4pack.py: {len(data)} -> {len(packed)} bytes")
+
+if __name__ == "__main__":
+    main()
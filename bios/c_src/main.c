@@ -6,6 +6,14 @@
 #include "cpudetect.h"
 #include "ide.h"
 #include "cmos.h"
+#include "bda.h"
+#include "ebda.h"
+#include "post.h"
+#include "memtest.h"
+#include "timeline.h"
+#include "benchmark.h"
+#include "memmap.h"
+#include "linux.h"
 
 #include "about.h"
 #include "setup.h"
@@ -14,10 +22,11 @@
 #define VERSION "?.??"
 #endif
 
-#define POST(x) outb(0x80, 0x10 + (x))
+#define POST(x) do { outb(0x80, 0x10 + (x)); timeline_mark(0x10 + (x)); } while(0)
 
 void fatal_error() { // TO UPDATE
     vga_print_string("MEMORY ERROR", 0, 0, 0x0F);
+    vga_flush();
     cli();
     asm volatile("hlt");
     while(1) {}
@@ -26,6 +35,7 @@ void fatal_error() { // TO UPDATE
 int cyrix_cpu = 0;
 char cpu_model[48];
 volatile uint32_t *cpuid_edx = (uint32_t*)0x5F0; // DX from reset is stored to 0x5F0 by ASM
+volatile struct bda_params *bda = (struct bda_params*)BDA_PARAMS_ADDR;
 int fpu_present = 0;
 int mem_total = 64; // base 64K already tested
 uint16_t cpuid;
@@ -41,92 +51,142 @@ struct memtest_regions_struct {
     {0x0100000, 48},
     {0x04A0000, 6}
 };
+#define MEMTEST_HOLE_REGION 2
+#define MEMTEST_HOLE_SHADOW_BLOCKS 2 // 0x4C0000 - 0x4FFFFF is the shadow RAM of the ROMs
 
 int skip_memory_test = 0;
 
-__attribute__ ((optimize(2))) void memory_test(int quick) {
-    // Cache is ON but we gonna invalidate it 
+static void memory_error(uint32_t addr) {
+    if(addr) fatal_error();
+}
+
+// Address lines: a distinct value at every power of two offset must not
+// alias the region base or another offset
+static void memory_test_address_lines(uint32_t base, uint32_t size) {
+    volatile uint32_t *mem = (volatile uint32_t *)base;
+
+    mem[0] = 0xA5A5A5A5;
+    for(uint32_t offset = 4; offset < size; offset <<= 1) {
+        mem[offset / 4] = offset;
+    }
+    asm volatile("wbinvd");
+    if(mem[0] != 0xA5A5A5A5) fatal_error();
+    for(uint32_t offset = 4; offset < size; offset <<= 1) {
+        if(mem[offset / 4] != offset) fatal_error();
+    }
+}
+
+// Data lines: walking one, the next dword holds the complement so the
+// bus does not keep the last value
+static void memory_test_data_lines(uint32_t base) {
+    volatile uint32_t *mem = (volatile uint32_t *)base;
+
+    for(int bit = 0; bit < 32; bit++) {
+        mem[0] = 1UL << bit;
+        mem[1] = ~(1UL << bit);
+        asm volatile("wbinvd");
+        if(mem[0] != (1UL << bit)) fatal_error();
+    }
+}
+
+// March C-: up(w0) up(r0,w1) up(r1,w0) down(r0,w1) down(r1,w0) up(r0)
+// Returns the number of bytes moved
+static uint32_t memory_test_march(uint32_t addr, uint32_t dwords) {
+    memtest_fill(addr, dwords, 0x00000000);
+    asm volatile("wbinvd");
+    memory_error(memtest_march_up(addr, dwords, 0x00000000, 0xFFFFFFFF));
+    asm volatile("wbinvd");
+    memory_error(memtest_march_up(addr, dwords, 0xFFFFFFFF, 0x00000000));
+    asm volatile("wbinvd");
+    memory_error(memtest_march_down(addr, dwords, 0x00000000, 0xFFFFFFFF));
+    asm volatile("wbinvd");
+    memory_error(memtest_march_down(addr, dwords, 0xFFFFFFFF, 0x00000000));
+    asm volatile("wbinvd");
+    memory_error(memtest_check(addr, dwords, 0x00000000));
+    return dwords * 4 * 10;
+}
+
+// Quick: two solid patterns, written with rep stosd and compared with repe scasd
+static uint32_t memory_test_quick(uint32_t addr, uint32_t dwords) {
+    memtest_fill(addr, dwords, 0x55AA55AA);
+    asm volatile("wbinvd");
+    memory_error(memtest_check(addr, dwords, 0x55AA55AA));
+    memtest_fill(addr, dwords, 0xAA55AA55);
+    asm volatile("wbinvd");
+    memory_error(memtest_check(addr, dwords, 0xAA55AA55));
+    return dwords * 4 * 4;
+}
+
+static void memory_test_draw(int quick, uint32_t mbs) {
+    char print_buf[32];
+    char num_buf[12];
+
+    itoa(mem_total, print_buf, 10);
+    if(quick) {
+        strcat(print_buf, " KB (q)");
+    } else {
+        strcat(print_buf, " KB");
+    }
+    if(mbs) {
+        strcat(print_buf, ", ");
+        strcat(print_buf, itoa(mbs, num_buf, 10));
+        strcat(print_buf, " MB/s");
+    }
+    vga_print_string(print_buf, 20, 10, 0x0F);
+    vga_flush();
+}
+
+void memory_test(int quick) {
+    // Cache is ON, wbinvd between the passes makes the reads come from RAM
     //
     // Test regions:
     // 0x0010000 - 0x009FFFF: start: 0x0010000, 9 blocks
     // 0x0100000 - 0x03FFFFF: start: 0x0100000, 48 blocks
-    // 0x04A0000 - 0x04FFFFF: start: 0x04A0000, 6 blocks
+    // 0x04A0000 - 0x04FFFFF: start: 0x04A0000, 6 blocks (2 with shadow RAM)
     // block = 64K
     //
     // Base 64K was already tested before and it should 
     // be working if we already hit this point
 
-
-    volatile uint32_t *memory = (volatile uint32_t *)0x00000000;
-
     mem_total = 64; // base 64k already tested
-    char print_buf[20];
-    int inc_amount;
-
-    if(quick) {
-        inc_amount = 32; 
-    } else {
-        inc_amount = 1;
-    }
-
+    if(bda->shadow_blocks) memtest_regions[MEMTEST_HOLE_REGION].blocks_64k = MEMTEST_HOLE_SHADOW_BLOCKS;
+    uint32_t kb_moved = 0;
+    uint32_t ticks_start = irq0_ticks;
+    uint32_t ticks_draw = ticks_start;
 
     for(int region=0; region < MEMTEST_REGIONS_TOTAL; region++) {
-        // 0x0010000
-        uint32_t mem_offset = memtest_regions[region].offset / 4;
+        uint32_t mem_offset = memtest_regions[region].offset;
         uint8_t blocks = memtest_regions[region].blocks_64k;
 
-        for(int block=0; block < blocks; block++) {
-
-            uint32_t ticks_next = irq0_ticks + 5; // Slow down
-
-            for(uint32_t wpos = 0; wpos < (0x10000/4); wpos+=inc_amount) { // uint32_t align is 4 so 1 offset = 4 bytes
-                volatile uint32_t *current_ptr = memory + mem_offset + wpos;
-                *current_ptr = 0x55AA55AA;
-            }
-            asm volatile("wbinvd");
-            for(uint32_t rpos = 0; rpos < (0x10000/4); rpos+=inc_amount) { // uint32_t align is 4 so 1 offset = 4 bytes
-                volatile uint32_t *current_ptr = memory + mem_offset + rpos;
-                if(*current_ptr != 0x55AA55AA) {
-                    // ERROR
-                    fatal_error();
-                }
-            }
-            // Swap bits
-            for(uint32_t wpos = 0; wpos < (0x10000/4); wpos+=inc_amount) { // uint32_t align is 4 so 1 offset = 4 bytes
-                volatile uint32_t *current_ptr = memory + mem_offset + wpos;
-                *current_ptr = 0xAA55AA55;
-            }
-            asm volatile("wbinvd");
-            for(uint32_t rpos = 0; rpos < (0x10000/4); rpos+=inc_amount) { // uint32_t align is 4 so 1 offset = 4 bytes
-                volatile uint32_t *current_ptr = memory + mem_offset + rpos;
-                if(*current_ptr != 0xAA55AA55) {
-                    // ERROR
-                    fatal_error();
-                }
-            }
-            // if mem test goes too fast, slow down by counting ticks
-            while(ticks_next > irq0_ticks) { asm("nop"); }
-
-            mem_total += 64;
-            mem_offset = mem_offset + 0x4000; // 0x10000 / 4
-            //vga_print_itoa(tested_memory_k, 20, 10, 0x0F, 10, 0);
+        memory_test_address_lines(mem_offset, blocks * 0x10000UL);
+        memory_test_data_lines(mem_offset);
 
+        for(int block=0; block < blocks; block++) {
             if(skip_memory_test==1) {
                 mem_total = 4096;
+                memory_test_draw(quick, 0);
+                return;
             }
-            itoa(mem_total, print_buf, 10);
+
             if(quick) {
-                strcat(print_buf, " KB (q)");
+                kb_moved += memory_test_quick(mem_offset, 0x10000/4) / 1024;
             } else {
-                strcat(print_buf, " KB");
+                kb_moved += memory_test_march(mem_offset, 0x10000/4) / 1024;
+            }
+
+            mem_total += 64;
+            mem_offset += 0x10000;
+
+            if(irq0_ticks - ticks_draw >= 10) { // redraw every 100 ms
+                memory_test_draw(quick, 0);
+                ticks_draw = irq0_ticks;
             }
-            vga_print_string(print_buf, 20, 10, 0x0F);
-            if(skip_memory_test==1) break;
-            
         }
-        
     }
 
+    uint32_t ticks = irq0_ticks - ticks_start;
+    if(ticks == 0) ticks = 1;
+    memory_test_draw(quick, kb_moved * 100 / ticks / 1024);
 }
 
 enum POST_action_enum {
@@ -164,7 +224,6 @@ void POST_irq1_int() {
                 break;
 
             case 0x3C: // F2
-                break; // to do in future
                 POST_action = POST_SYSTEM_TEST;
                 for(int x=0; x<80; x++) {
                     vga_print_char(' ', x, 24, 0x07);
@@ -186,6 +245,30 @@ void POST_irq1_int() {
     }
 }
 
+// The ring is only reserved on a chipset with the NMI timer
+static int profiler_enabled() {
+    return cmos_get(CMOS_NMI_PROFILER) && cmos_is_m8sbc() && cmos_chp_version() >= 0x0002;
+}
+
+void IDE_setup_drive() {
+    IDE_set_multiple();
+    IDE_store_params();
+    IDE_set_pio_mode();
+    IDE_build_fdpt();
+}
+
+void POST_exit() {
+    POST(0x09); // C exit
+    timeline_rebase(0x10000); // bios.asm sets the 18.2 Hz timer next
+
+    if(cmos_get(CMOS_LOCK_CMOS)) cmos_lock();
+
+    cli(); // Reset PIC to default
+    pic_remap(8); 
+    pic_set_mask(0x00); 
+    idt_restore_real_mode();
+}
+
 void main() {
     // Interrupts are disabled
     POST(0x00); // C entry
@@ -194,6 +277,7 @@ void main() {
     POST(0x01); // IDT set up
 
     cmos_status = cmos_read();
+    if(cmos_is_m8sbc() && cmos_chp_version() >= 0x0002) cmos_nmi_timer_stop();
     fpu_present = is_fpu_present();
     cyrix_cpu = is_cyrix_cpu();
 
@@ -202,6 +286,7 @@ void main() {
 
     POST(0x02); // CPU ident OK
     // PIT is not yet set
+    timeline_rebase(1193180 / 100);
     pit_set_int_freq(100);
     kb_clear_buffer();
     POST(0x03); // KB clear buffer OK
@@ -214,6 +299,32 @@ void main() {
 
     POST(0x04); // Timer and IRQ pass
 
+    // Warm boot: memory was tested by the previous POST, go straight to the boot sector
+    if(bda->post_flags & BDA_POST_WARM) {
+        mem_total = bda->mem_total_kb;
+        ebda_init(cmos_get(CMOS_DISK_CACHE), profiler_enabled());
+        memmap_build(mem_total);
+        IDE_probe_start(ide_name);
+        post_task_add(IDE_probe_step);
+        while(!post_tasks_done()) {
+            asm volatile("nop");
+        }
+        POST(0x08); // IDE probe done
+        if(IDE_probe_result()) {
+            ide_detected = 1;
+            IDE_setup_drive();
+        }
+
+        if(ide_detected && cmos_get(CMOS_LINUX_BOOT)) {
+            linux_load();
+            POST(0x0A); // Linux kernel load done
+        }
+
+        POST_exit();
+        return;
+    }
+
+    vga_init();
     POST_action = POST_NORMAL;
     irq1_register_callback(POST_irq1_int);
 
@@ -238,7 +349,6 @@ void main() {
 
     vga_print_string("---- Built " __DATE__ " " __TIME__ " / CHP V1 / Derived from BIOS by b-dmitry1 ----", 1, 23, 0x07);
 
-    /*
     vga_print_string("[ESC SKIP MEMORY TEST]  [F1 SETTINGS]  [F2 SYSTEM TEST]  [F3 ABOUT]", 7, 24, 0x0A);
     // highlight ESC, F1, F2, F3
     vga_set_char_attr(0x0F, 7+1, 24);
@@ -251,18 +361,6 @@ void main() {
     vga_set_char_attr(0x0F, 7+41, 24);
     vga_set_char_attr(0x0F, 7+58, 24);
     vga_set_char_attr(0x0F, 7+59, 24);
-    */
-
-    vga_print_string("[ESC SKIP MEMORY TEST]  [F1 SETTINGS]  [F3 ABOUT]", 15, 24, 0x0A);
-    // highlight ESC, F1, F3
-    vga_set_char_attr(0x0F, 15+1, 24);
-    vga_set_char_attr(0x0F, 15+2, 24);
-    vga_set_char_attr(0x0F, 15+3, 24);
-    
-    vga_set_char_attr(0x0F, 15+25, 24);
-    vga_set_char_attr(0x0F, 15+26, 24);
-    vga_set_char_attr(0x0F, 15+40, 24);
-    vga_set_char_attr(0x0F, 15+41, 24);
 
     vga_print_string(cpu_model, 20, 7, 0x0F);
 
@@ -279,15 +377,33 @@ void main() {
     sti();
     POST(0x06); // BIOS POST draw PASS
 
-    memory_test(cmos_get(CMOS_QUICK_MEMTEST));
-
+    // the drive spins up while the memory is tested
     vga_print_string("   Primary IDE : detecting...", 3, 12, 0x07);
+    vga_flush();
+    IDE_probe_start(ide_name);
+    post_task_add(IDE_probe_step);
 
-    IDE_reset();
+    memory_test(cmos_get(CMOS_QUICK_MEMTEST));
+    POST(0x07); // Memory test done
+    bda->mem_total_kb = mem_total; // reused by warm boots
+    ebda_init(cmos_get(CMOS_DISK_CACHE), profiler_enabled());
+    memmap_build(mem_total);
+
+    uint32_t last_ticks = 0;
+    while(!post_tasks_done()) {
+        if(last_ticks != irq0_ticks) { // to not redraw every few cpu cycles
+            vga_print_itoa(IDE_probe_elapsed() / 100, 20+13, 12, 0x07, 10, 0);
+            vga_flush();
+            last_ticks = irq0_ticks;
+        }
+        asm volatile("nop");
+    }
+    POST(0x08); // IDE probe done
 
-    if(IDE_wait_busy(500) && IDE_detect(ide_name)) { // wait 5 seconds
+    if(IDE_probe_result()) {
         ide_name[42] = 0;
         ide_detected = 1;
+        IDE_setup_drive();
         vga_print_string("              ", 20, 12, 0x0F);
         vga_print_string(ide_name, 20, 12, 0x0F);
     } else {
@@ -295,53 +411,44 @@ void main() {
         strcpy(ide_name, "None");
         ide_detected = 0;
     }
+    vga_flush();
       
 
     irq1_register_callback(NULL);
 
 
-    uint32_t boot_delay;
-
     if(ide_detected == 0) {
         POST_action = POST_SETTINGS;
     }
 
     switch(POST_action) {
         case POST_ABOUT:
-            boot_delay = irq0_ticks + 10;
             about_display();
             break;
 
+        case POST_SYSTEM_TEST:
+            benchmark_display(ide_detected);
+            break;
+
         case POST_SETTINGS:
-            boot_delay = irq0_ticks + 10;
             setup_display(cpuid, cyrix_cpu, mem_total, fpu_present, ide_name, ide_detected);
             break;
 
         default:
-            boot_delay = irq0_ticks + 100;
             break;
     }
 
-
-    while(1) {
-        if(irq0_ticks>boot_delay) {
-            break;
-        }
-        asm volatile("nop");
+    if(ide_detected && cmos_get(CMOS_LINUX_BOOT)) {
+        linux_load();
+        POST(0x0A); // Linux kernel load done
     }
 
-
-    if(cmos_get(CMOS_LOCK_CMOS)) cmos_lock();
-
-    
-    cli(); // Reset PIC to default
-    pic_remap(8); 
-    pic_set_mask(0x00); 
-    idt_restore_real_mode();
+    POST_exit();
 
     vga_restore_font();
 
     vga_clear(0x07);
+    vga_flush();
 
     return;
 }
@@ -0,0 +1,56 @@
+#include "memmap.h"
+#include "bda.h"
+
+// E820 table for INT 15h (isr/int15_at.asm), 88h/8Ah/E801h report ext_kb
+// Built from the RAM the memory test counted, call after ebda_init()
+
+#define MEMMAP_CONVENTIONAL_KB 640
+#define MEMMAP_EXTENDED_KB 3072
+#define MEMMAP_HOLE_BASE 0x4A0000 // 384 KB, repeats the 0x0A0000 - 0x100000 hole
+#define MEMMAP_HOLE_KB 384
+#define MEMMAP_HOLE_SHADOW_KB 128 // drivers/shadow.asm runs the ROMs from 0x4C0000 - 0x4FFFFF
+
+static void memmap_add(uint32_t base, uint32_t length, uint32_t type) {
+    if(length == 0 || ebda->memmap_count >= EBDA_MEMMAP_ENTRIES) return;
+
+    volatile struct e820_entry *entry = &ebda->memmap[ebda->memmap_count++];
+    entry->base = base;
+    entry->length = length;
+    entry->type = type;
+}
+
+// Takes up to max KB of the tested memory
+static uint32_t memmap_take(int *mem_kb, int max) {
+    int kb = (*mem_kb < max) ? *mem_kb : max;
+    *mem_kb -= kb;
+    return kb * 1024UL;
+}
+
+void memmap_build(int mem_kb) {
+    // same order as memtest_regions in main.c
+    uint32_t conventional = memmap_take(&mem_kb, MEMMAP_CONVENTIONAL_KB);
+    uint32_t extended = memmap_take(&mem_kb, MEMMAP_EXTENDED_KB);
+    uint32_t hole = memmap_take(&mem_kb, bda->shadow_blocks ? MEMMAP_HOLE_SHADOW_KB : MEMMAP_HOLE_KB);
+    uint32_t ebda_base = (uint32_t)ebda;
+
+    ebda->memmap_count = 0;
+    ebda->ext_kb = extended / 1024;
+
+    if(conventional > ebda_base) conventional = ebda_base;
+    memmap_add(0, conventional, E820_RAM);
+    memmap_add(ebda_base, 0xA0000 - ebda_base, E820_RESERVED);
+    memmap_add(0xC8000, 0x100000 - 0xC8000, E820_RESERVED); // ROM
+    memmap_add(0x100000, extended, E820_RAM);
+    if(0x100000 + extended >= 0x400000) { // only when extended RAM reaches it
+        memmap_add(0x400000, MEMMAP_HOLE_BASE - 0x400000, E820_RESERVED);
+    }
+
+    if(ebda->dcache_enabled) { // drivers/diskcache.asm keeps its sectors there
+        uint32_t dcache = EBDA_DCACHE_SETS * EBDA_DCACHE_WAYS * 512;
+        if(dcache > hole) dcache = hole;
+        memmap_add(EBDA_DCACHE_BASE, dcache, E820_RESERVED);
+        memmap_add(EBDA_DCACHE_BASE + dcache, hole - dcache, E820_RAM);
+    } else {
+        memmap_add(MEMMAP_HOLE_BASE, hole, E820_RAM);
+    }
+}
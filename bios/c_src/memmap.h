@@ -0,0 +1,12 @@
+#ifndef MEMMAP_H
+#define MEMMAP_H
+
+#include <stdint.h>
+#include "ebda.h"
+
+#define E820_RAM 1
+#define E820_RESERVED 2
+
+void memmap_build(int mem_kb);
+
+#endif
@@ -0,0 +1,83 @@
+; memtest.asm
+; Memory test engine for memory_test() in main.c
+; All routines are cdecl, addresses are linear, counts are in dwords
+; and return 0 if the memory is ok or the address of the first bad dword
+bits 32
+
+section .text
+
+global memtest_fill
+global memtest_check
+global memtest_march_up
+global memtest_march_down
+
+; void memtest_fill(uint32_t addr, uint32_t dwords, uint32_t pattern)
+memtest_fill:
+    push edi
+    mov edi, [esp + 8]
+    mov ecx, [esp + 12]
+    mov eax, [esp + 16]
+    rep stosd
+    pop edi
+    ret
+
+; uint32_t memtest_check(uint32_t addr, uint32_t dwords, uint32_t pattern)
+memtest_check:
+    push edi
+    mov edi, [esp + 8]
+    mov ecx, [esp + 12]
+    mov eax, [esp + 16]
+    repe scasd
+    mov eax, 0
+    je .done
+    lea eax, [edi - 4]
+.done:
+    pop edi
+    ret
+
+; March element, ascending addresses: read and compare, then write
+; uint32_t memtest_march_up(uint32_t addr, uint32_t dwords, uint32_t expect, uint32_t write)
+memtest_march_up:
+    push edi
+    mov edi, [esp + 8]
+    mov ecx, [esp + 12]
+    mov eax, [esp + 16]
+    mov edx, [esp + 20]
+.next:
+    cmp [edi], eax
+    jne .fail
+    mov [edi], edx
+    add edi, 4
+    dec ecx
+    jnz .next
+    xor eax, eax
+    pop edi
+    ret
+.fail:
+    mov eax, edi
+    pop edi
+    ret
+
+; March element, descending addresses
+; uint32_t memtest_march_down(uint32_t addr, uint32_t dwords, uint32_t expect, uint32_t write)
+memtest_march_down:
+    push edi
+    mov ecx, [esp + 12]
+    lea edi, [ecx * 4 - 4]
+    add edi, [esp + 8]
+    mov eax, [esp + 16]
+    mov edx, [esp + 20]
+.next:
+    cmp [edi], eax
+    jne .fail
+    mov [edi], edx
+    sub edi, 4
+    dec ecx
+    jnz .next
+    xor eax, eax
+    pop edi
+    ret
+.fail:
+    mov eax, edi
+    pop edi
+    ret
@@ -0,0 +1,13 @@
+#ifndef MEMTEST_H
+#define MEMTEST_H
+
+#include <stdint.h>
+
+// memtest.asm, counts are in dwords
+// check/march return 0 if ok or the address of the first bad dword
+void memtest_fill(uint32_t addr, uint32_t dwords, uint32_t pattern);
+uint32_t memtest_check(uint32_t addr, uint32_t dwords, uint32_t pattern);
+uint32_t memtest_march_up(uint32_t addr, uint32_t dwords, uint32_t expect, uint32_t write);
+uint32_t memtest_march_down(uint32_t addr, uint32_t dwords, uint32_t expect, uint32_t write);
+
+#endif
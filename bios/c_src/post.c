@@ -0,0 +1,48 @@
+#include "post.h"
+
+// POST tasks are stepped from the timer interrupt, so slow device waits
+// run while main() tests the memory. Steps must not block
+
+#define POST_TASKS_MAX 4
+
+static post_task_ptr post_tasks[POST_TASKS_MAX];
+static volatile uint8_t post_tasks_pending = 0; // bit per unfinished task
+static irq0_callback_ptr post_tick_chain = 0; // IRQ0 callback registered before post_tick
+static uint8_t post_tick_registered = 0;
+
+static void post_tick() {
+    for(int i=0; i<POST_TASKS_MAX; i++) {
+        if((post_tasks_pending & (1 << i)) && post_tasks[i]()) {
+            post_tasks_pending &= ~(1 << i);
+        }
+    }
+
+    if(post_tick_chain != NULL) {
+        post_tick_chain();
+    }
+}
+
+int post_task_add(post_task_ptr task) {
+    uint32_t flags = irq_save();
+    int added = 0;
+
+    for(int i=0; i<POST_TASKS_MAX; i++) {
+        if(!(post_tasks_pending & (1 << i))) {
+            post_tasks[i] = task;
+            post_tasks_pending |= (1 << i);
+            added = 1;
+            break;
+        }
+    }
+
+    if(!post_tick_registered) {
+        post_tick_chain = irq0_register_callback(post_tick);
+        post_tick_registered = 1;
+    }
+    irq_restore(flags);
+    return added;
+}
+
+int post_tasks_done() {
+    return post_tasks_pending == 0;
+}
@@ -0,0 +1,13 @@
+#ifndef POST_H
+#define POST_H
+
+#include <stdint.h>
+#include "interrupts.h"
+
+// Returns 1 once the task is finished
+typedef int (*post_task_ptr)(void);
+
+int post_task_add(post_task_ptr task);
+int post_tasks_done();
+
+#endif
@@ -5,6 +5,12 @@ enum bios_settings_setting {
     OPTION_QUICK_MEMTEST,
     OPTION_LBA_REPORTING,
     OPTION_LOCK_CMOS,
+    OPTION_DISK_CACHE,
+    OPTION_FULL_POST,
+    OPTION_LINUX_BOOT,
+    OPTION_NMI_PROFILER,
+    OPTION_SHADOW_ROMS,
+    OPTION_BOOT_TIMELINE,
     OPTION_OPEN_ABOUT
 };
 
@@ -17,13 +23,19 @@ struct bios_settings_struct {
 
 static int select = 0;
 
-#define SETTINGS_AMOUNT 5
+#define SETTINGS_AMOUNT 11
 static const struct bios_settings_struct bios_settings[SETTINGS_AMOUNT] =
 {
     {OPTION_QUICK_MEMTEST, "Fast memory test", "This option enables quick memory test which reduces boot time."},
     {OPTION_LBA_REPORTING, "Enable LBA support reporting", "This option controls LBA support BIOS reporting (INT 13h ax=0x41)."},
     {OPTION_LOCK_CMOS, "Lock CMOS after boot", "Enabling this option locks CMOS 0x40-0x5F NVRAM area after boot."},
+    {OPTION_DISK_CACHE, "Disk read cache", "Caches hard disk sectors in 128 KB of extended RAM. The read-ahead buffer takes 4 KB of conventional memory."},
+    {OPTION_FULL_POST, "Full POST on warm boot", "Runs memory tests and the logo screen on Ctrl-Alt-Del and software resets too."},
+    {OPTION_LINUX_BOOT, "Boot Linux kernel partition", "Loads the kernel (and initrd) from the first (and second) type DAh partition instead of the boot sector."},
+    {OPTION_NMI_PROFILER, "NMI sampling profiler", "Reserves 4 KB of conventional memory for NMIPROF.COM samples. Needs chipset version 0002 or newer."},
+    {OPTION_SHADOW_ROMS, "Shadow BIOS and option ROMs", "Runs the BIOS and option ROMs from cacheable RAM at 0x4C0000. Needs chipset version 0004 or newer."},
     {OPTION_EMPTY, "", ""},
+    {OPTION_BOOT_TIMELINE, "Boot timeline", "Time of every POST checkpoint of this boot."},
     {OPTION_OPEN_ABOUT, "Open About", "SeaPig information and acknowledgments."}
 };
 // OPTION_EMPTY cant be used twice in a row, or be first or last
@@ -64,6 +76,27 @@ static void draw_options() {
                 draw_type = DRAW_YES_NO;
                 draw_value[0] = cmos_get(CMOS_LOCK_CMOS) ? 1 : 0;
                 break;
+            case OPTION_DISK_CACHE:
+                draw_type = DRAW_YES_NO;
+                draw_value[0] = cmos_get(CMOS_DISK_CACHE) ? 1 : 0;
+                break;
+            case OPTION_FULL_POST:
+                draw_type = DRAW_YES_NO;
+                draw_value[0] = cmos_get(CMOS_FULL_POST) ? 1 : 0;
+                break;
+            case OPTION_LINUX_BOOT:
+                draw_type = DRAW_YES_NO;
+                draw_value[0] = cmos_get(CMOS_LINUX_BOOT) ? 1 : 0;
+                break;
+            case OPTION_NMI_PROFILER:
+                draw_type = DRAW_YES_NO;
+                draw_value[0] = cmos_get(CMOS_NMI_PROFILER) ? 1 : 0;
+                break;
+            case OPTION_SHADOW_ROMS:
+                draw_type = DRAW_YES_NO;
+                draw_value[0] = cmos_get(CMOS_SHADOW_ROMS) ? 1 : 0;
+                break;
+            case OPTION_BOOT_TIMELINE:
             case OPTION_OPEN_ABOUT:
                 draw_type = DRAW_OPTION_ONLY;
                 break;
@@ -195,6 +228,7 @@ static int dialog_yesno(int current, const char *msg) {
             vga_print_string("[Yes]", pos_x+27-5, pos_y+3, (yn_select == 1) ? 0x5F : 0x1F );
             redraw = 0;
         }
+        vga_flush();
 
         if(kb_is_available()) {
             uint8_t scancode = kb_get_scancode();
@@ -328,6 +362,7 @@ static void dialog_text(const char* title, const char* text) {
 
     // Wait for ESC/ENTER to close
     while(1) {
+        vga_flush();
         if(kb_is_available()) {
             uint8_t scancode = kb_get_scancode();
             if(scancode == 0x01 || scancode == 0x1C) { // ESC or Enter
@@ -368,6 +403,7 @@ void setup_display(uint16_t cpuid, int is_cyrix, int mem_total, int fpu_present,
     while(1) {
         static uint8_t extended = 0;
 
+        vga_flush();
         if(kb_is_available()) {
             uint8_t scancode = kb_get_scancode();
 
@@ -407,6 +443,27 @@ void setup_display(uint16_t cpuid, int is_cyrix, int mem_total, int fpu_present,
                             OPTION_TYPE = OPTION_TYPE_YESNO;
                             option_value[0] = cmos_get(CMOS_LOCK_CMOS);
                             break;
+                        case OPTION_DISK_CACHE:
+                            OPTION_TYPE = OPTION_TYPE_YESNO;
+                            option_value[0] = cmos_get(CMOS_DISK_CACHE);
+                            break;
+                        case OPTION_FULL_POST:
+                            OPTION_TYPE = OPTION_TYPE_YESNO;
+                            option_value[0] = cmos_get(CMOS_FULL_POST);
+                            break;
+                        case OPTION_LINUX_BOOT:
+                            OPTION_TYPE = OPTION_TYPE_YESNO;
+                            option_value[0] = cmos_get(CMOS_LINUX_BOOT);
+                            break;
+                        case OPTION_NMI_PROFILER:
+                            OPTION_TYPE = OPTION_TYPE_YESNO;
+                            option_value[0] = cmos_get(CMOS_NMI_PROFILER);
+                            break;
+                        case OPTION_SHADOW_ROMS:
+                            OPTION_TYPE = OPTION_TYPE_YESNO;
+                            option_value[0] = cmos_get(CMOS_SHADOW_ROMS);
+                            break;
+                        case OPTION_BOOT_TIMELINE:
                         case OPTION_OPEN_ABOUT:
                             OPTION_TYPE = OPTION_TYPE_OTHER;
                             break;
@@ -436,6 +493,24 @@ void setup_display(uint16_t cpuid, int is_cyrix, int mem_total, int fpu_present,
                         case OPTION_LOCK_CMOS:
                             cmos_set(CMOS_LOCK_CMOS, option_value[0]);
                             break;
+                        case OPTION_DISK_CACHE:
+                            cmos_set(CMOS_DISK_CACHE, option_value[0]);
+                            break;
+                        case OPTION_FULL_POST:
+                            cmos_set(CMOS_FULL_POST, option_value[0]);
+                            break;
+                        case OPTION_LINUX_BOOT:
+                            cmos_set(CMOS_LINUX_BOOT, option_value[0]);
+                            break;
+                        case OPTION_NMI_PROFILER:
+                            cmos_set(CMOS_NMI_PROFILER, option_value[0]);
+                            break;
+                        case OPTION_SHADOW_ROMS:
+                            cmos_set(CMOS_SHADOW_ROMS, option_value[0]);
+                            break;
+                        case OPTION_BOOT_TIMELINE:
+                            timeline_display();
+                            break;
                         case OPTION_OPEN_ABOUT:
                             about_display();
                             break;
@@ -10,6 +10,7 @@
 #include "ide.h"
 #include "cmos.h"
 #include "about.h"
+#include "timeline.h"
 
 void setup_display(uint16_t cpuid, int is_cyrix, int mem_total, int fpu_present, char *ide_name,  int ide_detected);
 
@@ -0,0 +1,101 @@
+// Host microbenchmark for the C BIOS runtime (utils.c), run with "make bench"
+// Prints TSC cycles per byte against plain byte loops. A modern host CPU
+// handles rep string instructions very differently from a 486, so compare
+// the columns with each other, not with the numbers on the board
+#include <stdio.h>
+#include <x86intrin.h>
+#include "utils.h"
+
+#define MAX_SIZE 16384
+#define ROUNDS 200
+
+static uint8_t src_buf[MAX_SIZE + 8];
+static uint8_t dest_buf[MAX_SIZE + 8];
+static volatile int sink;
+
+// byte at a time versions, as utils.c had them before
+static void byte_memset(void *s, int c, int n) {
+    volatile uint8_t *p = s;
+    while(n--) *p++ = (uint8_t)c;
+}
+
+static void byte_memcpy(void *dest, const void *src, int n) {
+    volatile uint8_t *d = dest;
+    const uint8_t *s = src;
+    while(n--) *d++ = *s++;
+}
+
+static int byte_memcmp(const void *s1, const void *s2, int n) {
+    const volatile uint8_t *p1 = s1;
+    const volatile uint8_t *p2 = s2;
+    while(n--) {
+        if(*p1 != *p2) return *p1 - *p2;
+        p1++;
+        p2++;
+    }
+    return 0;
+}
+
+enum bench_func {
+    BENCH_MEMSET,
+    BENCH_MEMCPY,
+    BENCH_MEMMOVE,
+    BENCH_MEMCMP,
+    BENCH_FUNCS
+};
+
+static const char *bench_names[BENCH_FUNCS] = {"memset", "memcpy", "memmove", "memcmp"};
+
+static void run(enum bench_func func, int optimised, uint8_t *dest, const uint8_t *src, int n) {
+    switch(func) {
+        case BENCH_MEMSET:
+            if(optimised) memset(dest, 0x55, n); else byte_memset(dest, 0x55, n);
+            break;
+        case BENCH_MEMCPY:
+            if(optimised) memcpy(dest, src, n); else byte_memcpy(dest, src, n);
+            break;
+        case BENCH_MEMMOVE: // overlapping, backwards copy
+            if(optimised) memmove(dest + 3, dest, n - 3); else byte_memcpy(dest + 3, dest, n - 3);
+            break;
+        case BENCH_MEMCMP:
+            if(optimised) sink = memcmp(dest, src, n); else sink = byte_memcmp(dest, src, n);
+            break;
+        default:
+            break;
+    }
+}
+
+// best of ROUNDS, in cycles per byte x100
+static unsigned long measure(enum bench_func func, int optimised, int n, int misalign) {
+    unsigned long long best = ~0ULL;
+
+    if(func == BENCH_MEMCMP) byte_memcpy(dest_buf + misalign, src_buf + misalign, n);
+
+    for(int round=0; round<ROUNDS; round++) {
+        unsigned long long start = __rdtsc();
+        run(func, optimised, dest_buf + misalign, src_buf + misalign, n);
+        unsigned long long cycles = __rdtsc() - start;
+        if(cycles < best) best = cycles;
+    }
+    return best * 100 / n;
+}
+
+int main() {
+    static const int sizes[] = {16, 64, 1024, MAX_SIZE};
+
+    for(int i=0; i<MAX_SIZE + 8; i++) src_buf[i] = (uint8_t)i;
+
+    printf("%-8s %6s %5s %12s %12s\n", "func", "bytes", "align", "byte loop", "utils.c");
+    for(int func=0; func<BENCH_FUNCS; func++) {
+        for(unsigned int s=0; s<sizeof(sizes)/sizeof(sizes[0]); s++) {
+            for(int misalign=0; misalign<2; misalign++) {
+                unsigned long plain = measure(func, 0, sizes[s], misalign);
+                unsigned long fast = measure(func, 1, sizes[s], misalign);
+                printf("%-8s %6d %5s %9lu.%02lu %9lu.%02lu\n", bench_names[func], sizes[s],
+                       misalign ? "+1" : "0", plain / 100, plain % 100, fast / 100, fast % 100);
+            }
+        }
+    }
+    printf("cycles per byte, best of %d runs\n", ROUNDS);
+    return 0;
+}
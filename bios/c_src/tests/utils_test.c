@@ -0,0 +1,161 @@
+// Host unit test for the C BIOS runtime (utils.c), run with "make test"
+// The runtime replaces the libc string functions in this program
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+
+#define BUF_SIZE 128
+#define GUARD 0xEE
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        printf("FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while(0)
+
+static uint8_t buf_a[BUF_SIZE];
+static uint8_t buf_b[BUF_SIZE];
+static uint8_t expect[BUF_SIZE];
+
+static void fill_pattern(uint8_t *buf, int seed) {
+    for(int i=0; i<BUF_SIZE; i++) {
+        buf[i] = (uint8_t)(i * 7 + seed);
+    }
+}
+
+static int same(const uint8_t *a, const uint8_t *b) {
+    for(int i=0; i<BUF_SIZE; i++) {
+        if(a[i] != b[i]) return 0;
+    }
+    return 1;
+}
+
+static void test_memset() {
+    for(int off=0; off<4; off++) {
+        for(int n=0; n<=64; n++) {
+            for(int i=0; i<BUF_SIZE; i++) buf_a[i] = expect[i] = GUARD;
+            for(int i=0; i<n; i++) expect[off + i] = 0x5A;
+
+            void *rc = memset(buf_a + off, 0x5A, n);
+            CHECK(rc == buf_a + off, "return value, off %d n %d", off, n);
+            CHECK(same(buf_a, expect), "off %d n %d", off, n);
+        }
+    }
+
+    memset(buf_a, 0x1FF, 16); // only the low byte counts
+    CHECK(buf_a[0] == 0xFF && buf_a[15] == 0xFF, "fill byte truncation");
+}
+
+static void test_memcpy() {
+    for(int doff=0; doff<4; doff++) {
+        for(int soff=0; soff<4; soff++) {
+            for(int n=0; n<=64; n++) {
+                fill_pattern(buf_b, 3);
+                for(int i=0; i<BUF_SIZE; i++) buf_a[i] = expect[i] = GUARD;
+                for(int i=0; i<n; i++) expect[doff + i] = buf_b[soff + i];
+
+                void *rc = memcpy(buf_a + doff, buf_b + soff, n);
+                CHECK(rc == buf_a + doff, "return value, doff %d soff %d n %d", doff, soff, n);
+                CHECK(same(buf_a, expect), "doff %d soff %d n %d", doff, soff, n);
+            }
+        }
+    }
+}
+
+static void test_memmove() {
+    for(int shift=-9; shift<=9; shift++) {
+        for(int start=16; start<20; start++) {
+            for(int n=0; n<=64; n++) {
+                fill_pattern(buf_a, 11);
+                for(int i=0; i<BUF_SIZE; i++) expect[i] = buf_a[i];
+                for(int i=0; i<n; i++) expect[start + shift + i] = buf_a[start + i];
+
+                void *rc = memmove(buf_a + start + shift, buf_a + start, n);
+                CHECK(rc == buf_a + start + shift, "return value, shift %d start %d n %d", shift, start, n);
+                CHECK(same(buf_a, expect), "shift %d start %d n %d", shift, start, n);
+            }
+        }
+    }
+}
+
+static int sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+static void test_memcmp() {
+    for(int n=0; n<=32; n++) {
+        fill_pattern(buf_a, 5);
+        fill_pattern(buf_b, 5);
+        CHECK(memcmp(buf_a + 1, buf_b + 1, n) == 0, "equal, n %d", n);
+
+        for(int pos=0; pos<n; pos++) {
+            buf_a[1 + pos] = 0x80;
+            buf_b[1 + pos] = 0x7F;
+            CHECK(memcmp(buf_a + 1, buf_b + 1, n) > 0, "greater, n %d pos %d", n, pos);
+            CHECK(memcmp(buf_b + 1, buf_a + 1, n) < 0, "less, n %d pos %d", n, pos);
+            buf_b[1 + pos] = 0x80;
+        }
+    }
+
+    // the first different byte decides, not the dword value
+    uint8_t low[4] = {1, 0, 0, 9};
+    uint8_t high[4] = {2, 0, 0, 0};
+    CHECK(sign(memcmp(low, high, 4)) == -1, "byte order");
+}
+
+static void check_itoa(int value, int base, const char *expected) {
+    char str[40];
+    char *rc = itoa(value, str, base);
+    int ok = (rc == str);
+    for(int i=0; ok; i++) {
+        if(str[i] != expected[i]) ok = 0;
+        if(expected[i] == '\0') break;
+    }
+    CHECK(ok, "itoa(%d, %d) = \"%s\", expected \"%s\"", value, base, str, expected);
+}
+
+static void test_itoa() {
+    check_itoa(0, 16, "0");
+    check_itoa(0xF, 16, "F");
+    check_itoa(0x10, 16, "10");
+    check_itoa(0x486, 16, "486");
+    check_itoa(0xABCDEF, 16, "ABCDEF");
+    check_itoa(0x7FFFFFFF, 16, "7FFFFFFF");
+    check_itoa(-1, 16, "FFFFFFFF");
+    check_itoa(0, 10, "0");
+    check_itoa(4096, 10, "4096");
+    check_itoa(-45, 10, "-45");
+    check_itoa(0x7FFFFFFF, 10, "2147483647");
+    check_itoa(5, 2, "101");
+}
+
+static void test_strings() {
+    char str[32];
+
+    strcpy(str, "Sea");
+    CHECK(strlen(str) == 3, "strlen after strcpy");
+    strcat(str, "Pig");
+    CHECK(strlen(str) == 6 && str[3] == 'P' && str[6] == '\0', "strcat");
+    CHECK(strlen("") == 0, "empty strlen");
+}
+
+int main() {
+    test_memset();
+    test_memcpy();
+    test_memmove();
+    test_memcmp();
+    test_itoa();
+    test_strings();
+
+    if(failures) {
+        printf("utils_test: %d failures\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("utils_test: all passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+#include "timeline.h"
+#include "x86io.h"
+#include "interrupts.h"
+#include "utils.h"
+#include "vga.h"
+
+volatile struct timeline *timeline = (struct timeline*)TIMELINE_EARLY_ADDR;
+volatile uint16_t *bda_ticks_low = (uint16_t*)0x46C;
+static volatile uint32_t *timeline_irq0_ticks = &irq0_ticks;
+
+// BDA ticks (assembly INT 08h) until the first rebase, irq0_ticks after
+static int timeline_irq0 = 0;
+
+static uint32_t timeline_ticks() {
+    if(timeline_irq0) return *timeline_irq0_ticks;
+    return *bda_ticks_low;
+}
+
+// With interrupts off the tick count stands still, a counter reload only
+// shows as IRQ0 waiting in the PIC
+static int timeline_irq0_pending() {
+    uint32_t flags;
+    asm volatile ("pushf\n\tpop %0" : "=r"(flags));
+    if(flags & 0x200) return 0; // IF, the timer interrupt counts the reloads
+    outb(0x20, 0x0A); // OCW3: read IRR
+    return inb(0x20) & 0x01;
+}
+
+static void timeline_irq0_clear() {
+    if(!timeline_irq0_pending()) return;
+    outb(0x20, 0x0C); // OCW3: poll, acknowledges IRQ0 (highest priority)
+    inb(0x20);
+    outb(0x20, 0x60); // specific EOI, IRQ0
+}
+
+// sets *imprecise when the counter reloaded without a tick, the time is
+// then a lower bound
+static uint32_t timeline_clocks(int *imprecise) {
+    uint32_t ticks;
+    uint16_t count;
+    int pending;
+
+    do { // a tick or a reload between the reads would mismatch the count
+        pending = timeline_irq0_pending();
+        ticks = timeline_ticks();
+        outb(0x43, 0x00); // latch channel 0
+        count = inb(0x40);
+        count |= inb(0x40) << 8;
+    } while(ticks != timeline_ticks() || pending != timeline_irq0_pending());
+
+    // mode 2 counts from period down to 1, 0 reads as 65536
+    uint32_t in_period = (timeline->period - count) & 0xFFFF;
+    uint32_t now = timeline->base + (ticks - timeline->ticks) * timeline->period + in_period;
+
+    *imprecise = pending;
+    if(pending) { // at least one reload since the last checkpoint, maybe more
+        timeline_irq0_clear();
+        timeline->base += timeline->period;
+        now += timeline->period;
+    }
+    return now;
+}
+
+uint32_t timeline_now() {
+    int imprecise;
+    return timeline_clocks(&imprecise);
+}
+
+void timeline_mark(uint8_t code) {
+    if(timeline->signature != TIMELINE_SIGNATURE) return;
+    if(timeline->count >= timeline->max) return;
+
+    volatile struct timeline_entry *entry = &timeline->entries[timeline->count];
+    int imprecise;
+    entry->code = code;
+    entry->clocks = timeline_clocks(&imprecise);
+    entry->flags = imprecise ? TIMELINE_IMPRECISE : 0;
+    timeline->count++;
+}
+
+void timeline_rebase(uint32_t period) {
+    if(timeline->signature != TIMELINE_SIGNATURE) return;
+
+    timeline->base = timeline_now();
+    timeline_irq0 = 1;
+    timeline->ticks = *timeline_irq0_ticks;
+    timeline->period = period;
+    timeline_irq0_clear(); // the new period starts clean
+}
+
+void timeline_move(volatile struct timeline *dest) {
+    memcpy((void*)dest, (void*)timeline, sizeof(struct timeline));
+    timeline = dest;
+}
+
+////// setup page //////
+
+static const struct {
+    uint8_t code;
+    const char *name;
+} timeline_names[] = {
+    {0x05, "IVT and BDA"},
+    {0x06, "Option ROMs"},
+    {0x07, "Video mode"},
+    {0x08, "CPU cache on"},
+    {0x09, "PIT init"},
+    {0x0A, "Boot sector"},
+    {0x0B, "INT 19h handoff"},
+    {0x10, "C entry"},
+    {0x11, "IDT set up"},
+    {0x12, "CPU ident"},
+    {0x13, "Keyboard"},
+    {0x14, "Timer IRQ"},
+    {0x15, "Logo"},
+    {0x16, "POST screen"},
+    {0x17, "Memory test"},
+    {0x18, "IDE probe"},
+    {0x19, "C exit"},
+    {0x1A, "Linux kernel"}
+};
+
+// PIT clocks -> "ms.uuu"
+static void timeline_format(uint32_t clocks, char *buf) {
+    uint32_t us = clocks / 1193 * 1000 + (clocks % 1193) * 1000 / 1193;
+    char frac[8];
+
+    itoa(us / 1000, buf, 10);
+    strcat(buf, ".");
+    itoa(us % 1000 + 1000, frac, 10); // keeps the leading zeros
+    strcat(buf, frac + 1);
+    strcat(buf, " ms");
+}
+
+void timeline_display() {
+    char buf[20];
+
+    vga_clear(0x17);
+
+    vga_print_string("POST Timeline", 33, 0, 0x07);
+    for(int x=0; x<80; x++) {
+        vga_set_char_attr(0x2F, x, 0);
+        vga_set_char_attr(0x0F, x, 24);
+        vga_print_char('=', x, 23, 0x1F);
+    }
+
+    vga_print_string("Time since the timer start, left in the EBDA for DOS tools (signature 'TL')", 2, 2, 0x17);
+    vga_print_string("> - interrupts were off, at least this long", 2, 17, 0x17);
+
+    for(int i=0; i<timeline->count; i++) {
+        int x = (i < 12) ? 2 : 42;
+        int y = 4 + (i % 12);
+
+        itoa(timeline->entries[i].code + 0x100, buf, 16); // 2 digits
+        vga_print_string(buf + 1, x, y, 0x1F);
+        for(unsigned int n=0; n<sizeof(timeline_names)/sizeof(timeline_names[0]); n++) {
+            if(timeline_names[n].code == timeline->entries[i].code) {
+                vga_print_string(timeline_names[n].name, x + 4, y, 0x17);
+            }
+        }
+        if(timeline->entries[i].flags & TIMELINE_IMPRECISE) {
+            vga_print_char('>', x + 20, y, 0x1F);
+        }
+        timeline_format(timeline->entries[i].clocks, buf);
+        vga_print_string(buf, x + 21, y, 0x1F);
+    }
+
+    vga_print_string("Press ESC to exit", 31, 24, 0x0F);
+
+    kb_clear_buffer();
+
+    while(1) {
+        vga_flush();
+        if(kb_is_available()) {
+            uint8_t scancode = kb_get_scancode();
+            if(scancode==0x01) { // ESC
+                break;
+            }
+        }
+    }
+}
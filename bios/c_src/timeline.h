@@ -0,0 +1,39 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdint.h>
+
+// POST timeline, timestamps are PIT input clocks (1193180 Hz) since the
+// assembly BIOS started the timer, see drivers/timeline.asm
+// Layout must match data/ebda.asm
+
+#define TIMELINE_ENTRIES 24
+#define TIMELINE_EARLY_ADDR 0x500 // until the EBDA is placed
+#define TIMELINE_SIGNATURE 0x4C54 // 'TL'
+#define TIMELINE_IMPRECISE 0x01 // entry flags: whole periods may be missing
+
+struct timeline_entry {
+    uint8_t code;           // POST code (port 0x80 value)
+    uint8_t flags;
+    uint32_t clocks;
+} __attribute__((packed));
+
+struct timeline {
+    uint16_t signature;
+    uint8_t count;
+    uint8_t max;
+    uint32_t base;          // PIT clocks at the last timer reprogram
+    uint32_t ticks;         // tick count at the last reprogram
+    uint32_t period;        // PIT clocks per tick
+    struct timeline_entry entries[TIMELINE_ENTRIES];
+} __attribute__((packed));
+
+extern volatile struct timeline *timeline;
+
+uint32_t timeline_now(); // PIT clocks since the timer start
+void timeline_mark(uint8_t code);
+void timeline_rebase(uint32_t period); // call before reprogramming the PIT
+void timeline_move(volatile struct timeline *dest);
+void timeline_display();
+
+#endif
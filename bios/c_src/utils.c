@@ -1,9 +1,26 @@
 #include "utils.h"
 
+static const char itoa_digits[] = "0123456789ABCDEF";
+
+// Base 16 is cut with shifts, the value is taken as unsigned
+static char *itoa_hex(uint32_t value, char *str) {
+    int digits = 1;
+    while(digits < 8 && (value >> (digits * 4))) digits++;
+
+    str[digits] = '\0';
+    while(digits--) {
+        str[digits] = itoa_digits[value & 0xF];
+        value >>= 4;
+    }
+    return str;
+}
+
 char *itoa(int value, char *str, int base) {
     char *rc = str;
     char *ptr;
     char *low;
+
+    if (base == 16) return itoa_hex(value, str);
  
     // Handle negative numbers for base 10
     if (value < 0 && base == 10) {
@@ -15,8 +32,7 @@ char *itoa(int value, char *str, int base) {
  
     // Convert integer to string
     do {
-        int rem = value % base;
-        *ptr++ = (rem < 10) ? (rem + '0') : (rem - 10 + 'A');
+        *ptr++ = itoa_digits[value % base];
         value /= base;
     } while (value != 0);
  
@@ -55,10 +71,90 @@ size_t strlen(const char *s) {
     return (size_t)(p - s);
 }
 
+// The mem functions move bytes until the destination is dword aligned,
+// then dwords with rep stosd / rep movsd and the rest as bytes.
+// Counts are uintptr_t so the same code builds for the host tests (tests/)
+
 void *memset(void *s, int c, int n) {
-    unsigned char *p = s;
-    while (n--) {
-        *p++ = (unsigned char)c;
+    void *d = s;
+    uintptr_t count = n;
+    uintptr_t head = -(uintptr_t)s & 3;
+    uint32_t fill = (uint8_t)c * 0x01010101;
+
+    if (count < 8) {
+        asm volatile("rep stosb" : "+D"(d), "+c"(count) : "a"(fill) : "memory");
+        return s;
     }
+
+    uintptr_t dwords = (count - head) >> 2;
+    uintptr_t tail = (count - head) & 3;
+    asm volatile("rep stosb" : "+D"(d), "+c"(head) : "a"(fill) : "memory");
+    asm volatile("rep stosl" : "+D"(d), "+c"(dwords) : "a"(fill) : "memory");
+    asm volatile("rep stosb" : "+D"(d), "+c"(tail) : "a"(fill) : "memory");
     return s;
-}
\ No newline at end of file
+}
+
+void *memcpy(void *dest, const void *src, int n) {
+    void *d = dest;
+    uintptr_t count = n;
+    uintptr_t head = -(uintptr_t)dest & 3;
+
+    if (count < 8) {
+        asm volatile("rep movsb" : "+D"(d), "+S"(src), "+c"(count) : : "memory");
+        return dest;
+    }
+
+    uintptr_t dwords = (count - head) >> 2;
+    uintptr_t tail = (count - head) & 3;
+    asm volatile("rep movsb" : "+D"(d), "+S"(src), "+c"(head) : : "memory");
+    asm volatile("rep movsl" : "+D"(d), "+S"(src), "+c"(dwords) : : "memory");
+    asm volatile("rep movsb" : "+D"(d), "+S"(src), "+c"(tail) : : "memory");
+    return dest;
+}
+
+void *memmove(void *dest, const void *src, int n) {
+    if ((uintptr_t)dest - (uintptr_t)src >= (uintptr_t)n) {
+        return memcpy(dest, src, n); // no overlap or dest below src
+    }
+
+    // dest overlaps the end of src, copy backwards from the last byte
+    // DF is set only inside each asm statement
+    uint8_t *d = (uint8_t*)dest + n - 1;
+    const uint8_t *s = (const uint8_t*)src + n - 1;
+    uintptr_t count = n;
+    uintptr_t tail = (uintptr_t)(d + 1) & 3;
+
+    if (count < 8) {
+        asm volatile("std\n\trep movsb\n\tcld" : "+D"(d), "+S"(s), "+c"(count) : : "memory");
+        return dest;
+    }
+
+    uintptr_t dwords = (count - tail) >> 2;
+    uintptr_t head = (count - tail) & 3;
+    asm volatile("std\n\trep movsb\n\tcld" : "+D"(d), "+S"(s), "+c"(tail) : : "memory");
+    d -= 3;
+    s -= 3;
+    asm volatile("std\n\trep movsl\n\tcld" : "+D"(d), "+S"(s), "+c"(dwords) : : "memory");
+    d += 3;
+    s += 3;
+    asm volatile("std\n\trep movsb\n\tcld" : "+D"(d), "+S"(s), "+c"(head) : : "memory");
+    return dest;
+}
+
+int memcmp(const void *s1, const void *s2, int n) {
+    const uint8_t *p1 = s1;
+    const uint8_t *p2 = s2;
+
+    // skip the equal dwords, the bytes of the first different one decide
+    while (n >= 4 && *(const uint32_t*)p1 == *(const uint32_t*)p2) {
+        p1 += 4;
+        p2 += 4;
+        n -= 4;
+    }
+    while (n--) {
+        if (*p1 != *p2) return *p1 - *p2;
+        p1++;
+        p2++;
+    }
+    return 0;
+}
@@ -13,5 +13,8 @@ char *strcpy(char *dest, const char *src);
 size_t strlen(const char *s);
 
 void *memset(void *s, int c, int n);
+void *memcpy(void *dest, const void *src, int n);
+void *memmove(void *dest, const void *src, int n);
+int memcmp(const void *s1, const void *s2, int n);
 
 #endif
\ No newline at end of file
@@ -1,19 +1,83 @@
 #include "vga.h"
-static volatile uint8_t *screen = (uint8_t*)0xB8000;
+#include "interrupts.h"
+
+// Text output is drawn into vga_buffer in RAM and vga_flush() copies the
+// changed spans to 0xB8000. Every ISA cycle costs 38 waitstates, so only
+// cells that differ from vga_shown (what is on the screen) are copied
+
 static volatile uint16_t *screen16 = (uint16_t*)0xB8000;
 
+static uint16_t vga_buffer[VGA_CELLS];
+static uint16_t vga_shown[VGA_CELLS];
 
+// Dirty span per row, first > last when the row is clean
+static uint8_t dirty_first[VGA_ROWS];
+static uint8_t dirty_last[VGA_ROWS];
+
+static inline void vga_copy16(volatile uint16_t *dest, const volatile uint16_t *src, uint32_t count) {
+    asm volatile("rep movsw" : "+D"(dest), "+S"(src), "+c"(count) : : "memory");
+}
+
+// Marks cells first..last (buffer indexes) as changed
+// Also called from IRQ1 (POST_irq1_int), so interrupts are off meanwhile
+static void vga_mark(int first, int last) {
+    uint32_t flags = irq_save();
+    for(int y = first / VGA_COLS; y <= last / VGA_COLS; y++) {
+        int from = (y == first / VGA_COLS) ? first % VGA_COLS : 0;
+        int to = (y == last / VGA_COLS) ? last % VGA_COLS : VGA_COLS - 1;
+        if(from < dirty_first[y]) dirty_first[y] = from;
+        if(to > dirty_last[y]) dirty_last[y] = to;
+    }
+    irq_restore(flags);
+}
+
+static void vga_mark_clean() {
+    for(int y=0; y<VGA_ROWS; y++) {
+        dirty_first[y] = 0xFF;
+        dirty_last[y] = 0;
+    }
+}
+
+// Takes over what is on the screen, call before any other vga_ function
+void vga_init() {
+    vga_copy16(vga_shown, screen16, VGA_CELLS);
+    memcpy(vga_buffer, vga_shown, sizeof(vga_buffer));
+    vga_mark_clean();
+}
+
+void vga_flush() {
+    for(int y=0; y<VGA_ROWS; y++) {
+        uint32_t flags = irq_save();
+        int first = y * VGA_COLS + dirty_first[y];
+        int last = y * VGA_COLS + dirty_last[y];
+        dirty_first[y] = 0xFF;
+        dirty_last[y] = 0;
+
+        // trim the cells that were rewritten with the same value
+        while(first <= last && vga_buffer[first] == vga_shown[first]) first++;
+        while(first <= last && vga_buffer[last] == vga_shown[last]) last--;
+
+        if(first <= last) {
+            vga_copy16(screen16 + first, vga_buffer + first, last - first + 1);
+            vga_copy16(vga_shown + first, vga_buffer + first, last - first + 1);
+        }
+        irq_restore(flags);
+    }
+}
 
 void vga_print_char(char c, int x, int y, uint8_t attr) {
-    volatile uint16_t *pos = screen16 + (y * 80 + x);
-    *pos = (c | (attr << 8));
+    int pos = y * VGA_COLS + x;
+    vga_buffer[pos] = (uint8_t)c | (attr << 8);
+    vga_mark(pos, pos);
 }
 
 void vga_print_string(const char *str, int x, int y, uint8_t attr) {
-    volatile uint16_t *pos = screen16 + (y * 80 + x);
-    while(*str) {
-        *pos++ = ((*str++) | (attr << 8));
+    int pos = y * VGA_COLS + x;
+    int first = pos;
+    while(*str && pos < VGA_CELLS) {
+        vga_buffer[pos++] = (uint8_t)(*str++) | (attr << 8);
     }
+    if(pos > first) vga_mark(first, pos - 1);
 }
 
 void vga_print_itoa(int value, int x, int y, uint8_t attr, int base, int width) { // width = extra parameter spaces to clear previous data
@@ -23,21 +87,22 @@ void vga_print_itoa(int value, int x, int y, uint8_t attr, int base, int width)
     // clear extra spaces
     int len = strlen(str);
     for(int i=len;i<width;i++) {
-        vga_print_char(x, y + i, ' ', attr);
+        vga_print_char(' ', x + i, y, attr);
     }
 }
 
 void vga_set_char_attr(uint8_t attr, int x, int y) {
-    volatile uint8_t *pos = screen + (y * 80 + x)*2 + 1;
-    *pos = attr;
+    int pos = y * VGA_COLS + x;
+    vga_buffer[pos] = (vga_buffer[pos] & 0x00FF) | (attr << 8);
+    vga_mark(pos, pos);
 }
 
 void vga_clear(uint8_t attr) {
-    for(int x=0; x<80; x++) {
-        for(int y=0; y<25; y++) {
-            vga_print_char(' ', x, y, attr); // clear screen and set attributes to default
-        }
+    uint16_t cell = ' ' | (attr << 8);
+    for(int i=0; i<VGA_CELLS; i++) {
+        vga_buffer[i] = cell;
     }
+    vga_mark(0, VGA_CELLS - 1);
 }
 
 
@@ -129,24 +194,19 @@ void vga_draw_logo(uint8_t d_x, uint8_t d_y) {
         for(int x=0;x<17;x++) {
             //int t_x = x + 60;
             //int t_y = y + 1;
-            int addr = ((d_y+y) * 80 + (d_x+x)) * 2;
             uint8_t cell = cell_map[y][x];
             if(cell==0xC0 || cell==0xC1) cell = ' '; // PATCH, cells 0xC0 and 0xC1 contain extra logo
-            screen[addr] = cell;
             
             if(y==2) {
-                screen[addr + 1] = 0x0F; // white, for the bottom row
+                vga_print_char(cell, d_x+x, d_y+y, 0x0F); // white, for the bottom row
             } else {
-                screen[addr + 1] = 0x09; // blue, for the top two rows
+                vga_print_char(cell, d_x+x, d_y+y, 0x09); // blue, for the top two rows
             }
         }
     }
 }
 
 void vga_draw_extra_logo(uint8_t d_x, uint8_t d_y) {
-    int addr = (d_y*80 + d_x) * 2;
-    screen[addr] = 0xC0;
-    screen[addr+1] = 0x06;
-    screen[addr+2] = 0xC1;
-    screen[addr+3] = 0x06;
+    vga_print_char(0xC0, d_x, d_y, 0x06);
+    vga_print_char(0xC1, d_x+1, d_y, 0x06);
 }
\ No newline at end of file
@@ -8,6 +8,13 @@
 #define VGA_SEQ_INDEX           0x3C4
 #define VGA_GRAPHICS_INDEX      0x3CE
 
+#define VGA_COLS                80
+#define VGA_ROWS                25
+#define VGA_CELLS               (VGA_COLS * VGA_ROWS)
+
+void vga_init();
+void vga_flush();
+
 void vga_print_char(char c, int x, int y, uint8_t attr);
 void vga_print_string(const char *str, int x, int y, uint8_t attr);
 void vga_print_itoa(int value, int x, int y, uint8_t attr, int base, int width);
@@ -2,7 +2,9 @@
 
 bios_data:
 	dw 0x3F8, 0x2F8, 0x3E8, 0x2E8	; 0x00 - COM port numbers
-	dw 0x378, 0x278, 0, 0		; 0x08 - LPT port numbers
+	dw 0x378, 0x278, 0		; 0x08 - LPT port numbers
+ebda_segment:
+	dw 0			; 0x0E - EBDA segment (0 - no EBDA)
 
 bios_equip:
 	dw 0x082D		; 0x10 - equipment
@@ -80,7 +82,7 @@ new_day:
 ctrl_break:
 	db 0			; 0x71 - Ctrl+Break pressed
 warm_boot:
-	dw 0x1234		; 0x72 - warm boot 0x1234, cold boot otherwise
+	dw 0			; 0x72 - warm boot 0x1234, cold boot otherwise
 
 ; HDD
 hdd_last_status:
@@ -95,7 +97,7 @@ hdd_control:
 lpt_timeouts:
 	times 4 db 0		; 0x78 - LPT timeouts
 com_timeouts:
-	times 4 db 0		; 0x7C - COM timeouts
+	times 4 db 1		; 0x7C - COM timeouts, seconds
 
 ; Keyboard buffer
 keyb_buffer_start:
@@ -145,10 +147,13 @@ key_flags3:
 key_flags4:
 	db 0			; 0x97 - keyboard flags 4
 
-	dw 0, 0			; 0x98 - wait flag address
-	dd 0			; 0x9C - wait counter
+wait_flag_ptr:
+	dw 0, 0			; 0x98 - wait flag address (INT 15h AH=83h)
+wait_count:
+	dd 0			; 0x9C - wait counter, microseconds
 
-	db 0			; 0xA0 - wait flag
+wait_active:
+	db 0			; 0xA0 - wait flag: bit 0 - in progress, bit 7 - elapsed
 
 	times 7 db 0		; 0xA1
 
@@ -184,4 +189,47 @@ video_attr:
 bios_temp:
 	dw 0, 0			; temporary data buffer
 
+	db 0			; 0xC3 - reserved
+
+; IDE drive 0 parameters, filled by the C POST (c_src/ide.c)
+ide_multiple:
+	db 0			; 0xC4 - sectors per READ/WRITE MULTIPLE block (0 - disabled)
+ide_flags:
+	db 0			; 0xC5 - bit 0 - LBA, bit 1 - 48-bit LBA, bit 2 - IORDY supported
+ide_cylinders:
+	dw 0			; 0xC6 - IDENTIFY cylinders (0 - no drive)
+ide_sectors:
+	dq 0			; 0xC8 - total number of user addressable sectors
+ide_heads:
+	db 0			; 0xD0 - IDENTIFY heads
+ide_spt:
+	db 0			; 0xD1 - IDENTIFY sectors per track
+ide_pio_mode:
+	db 0			; 0xD2 - PIO mode set with SET FEATURES
+
+; POST state, kept over a warm boot
+post_flags:
+	db 0			; 0xD3 - bit 0 - this POST was a warm boot, bit 1 - Linux kernel loaded
+mem_total_kb:
+	dw 0			; 0xD4 - memory size measured by the last full POST (KB)
+
+; Settings snapshot, published by the C POST (c_src/cmos.c)
+; Runtime services read it instead of the CMOS ports, which cmos_lock() locks
+bios_settings:
+	db 0			; 0xD6 - bit 0 - LBA reporting, bit 1 - disk cache, bit 2 - full POST on warm boot, bit 3 - lock CMOS
+
+uptime_ticks:
+	dd 0			; 0xD7 - timer ticks since the boot, not reset at midnight (drivers/usclock.asm)
+
+; Text mode TTY state (isr/int10_tty.asm)
+tty_flags:
+	db 0			; 0xDB - bit 0 - CRTC cursor behind cursor_pos, written on the next tick
+tty_cursor:
+	dw 0xFFFF		; 0xDC - cursor_pos that tty_offset belongs to
+tty_offset:
+	dw 0			; 0xDE - video memory offset of that cursor position
+
+shadow_blocks:
+	dw 0			; 0xE0 - 16 KB blocks of 0xC0000 - 0xFFFFF read from shadow RAM (drivers/shadow.asm)
+
 bios_data_end:
@@ -0,0 +1,86 @@
+; Extended BIOS Data Area layout
+; Placed at the top of conventional memory by the C POST (c_src/ebda.c),
+; segment at 0x40:0x0E. Layout must match c_src/ebda.h
+
+; Disk cache geometry
+%define DCACHE_SETS		64
+%define DCACHE_WAYS		4	; slot tag offset math assumes 4
+%define DCACHE_READAHEAD	8	; sectors read past a missed request
+
+; POST timeline (drivers/timeline.asm, c_src/timeline.c)
+; Kept at TIMELINE_EARLY until the C POST places the EBDA
+%define TIMELINE_ENTRIES	24
+%define TIMELINE_EARLY		0x0500	; linear, 0x50:0x00
+%define TIMELINE_SIGNATURE	0x4C54	; 'TL'
+%define TIMELINE_IMPRECISE	0x01	; entry flags: whole periods may be missing
+
+struc timeline
+.signature:		resw 1		; 0x00 - TIMELINE_SIGNATURE
+.count:			resb 1		; 0x02 - entries used
+.max:			resb 1		; 0x03 - TIMELINE_ENTRIES
+.base:			resd 1		; 0x04 - PIT clocks at the last timer reprogram
+.ticks:			resd 1		; 0x08 - timer tick count at the last reprogram
+.period:		resd 1		; 0x0C - PIT clocks per tick
+.entries:		resb TIMELINE_ENTRIES * 6	; 0x10 - POST code byte, flags byte, PIT clocks dword
+endstruc
+
+; INT 15h memory map (isr/int15_at.asm), built by c_src/memmap.c
+%define MEMMAP_ENTRIES		8
+%define MEMMAP_ENTRY_SIZE	20	; E820: qword base, qword length, dword type
+
+; Serial ring buffers for COM1/COM2 (drivers/serial.asm), sizes are powers of two
+%define SERIAL_PORTS		2
+%define SERIAL_RX_SIZE		1024
+%define SERIAL_TX_SIZE		256
+
+struc serial
+.base:			resw 1		; 0x00 - I/O base, 0 - not set up, polled
+.flags:			resb 1		; 0x02 - bit 0: 16550A FIFO enabled
+.lsr:			resb 1		; 0x03 - line errors seen by the IRQ
+.rx_head:		resw 1		; 0x04 - written by the IRQ
+.rx_tail:		resw 1		; 0x06
+.tx_head:		resw 1		; 0x08
+.tx_tail:		resw 1		; 0x0A - written by the IRQ
+			resd 1
+.rx:			resb SERIAL_RX_SIZE	; 0x10
+.tx:			resb SERIAL_TX_SIZE
+endstruc
+
+; NMI sampling profiler (drivers/profiler.asm), ring allocated by c_src/ebda.c
+%define PROFILE_ENTRIES		1024	; 4 KB of IP, CS pairs
+%define PROFILE_PERIOD		11932	; PIT clocks per sample by default, 100 Hz
+
+struc profile
+.head:			resw 1		; 0x00 - next entry to write, advanced by the NMI
+.tail:			resw 1		; 0x02 - oldest entry, advanced by the reader
+.dropped:		resd 1		; 0x04 - samples lost while the ring was full
+.count:			resd 1		; 0x08 - samples taken since the start
+.entries:		resw 1		; 0x0C - ring size, 0 - profiler not available
+.ring:			resw 1		; 0x0E - EBDA offset of the ring, dword entries: IP, CS
+.active:		resb 1		; 0x10 - 1 while sampling, other NMIs are errors
+			resb 15
+endstruc
+
+struc ebda
+.size_kb:		resb 1		; 0x00 - EBDA size in KB
+			resb 15
+.dcache_enabled:	resb 1		; 0x10 - disk cache enabled (CMOS 0x40 bit 3)
+			resb 3
+.dcache_hits:		resd 1		; 0x14 - sectors served from the cache
+.dcache_misses:		resd 1		; 0x18 - sectors read from the drive
+			resd 1
+.dcache_next:		resb DCACHE_SETS	; 0x20 - next way to replace, per set
+.dcache_tags:		resd DCACHE_SETS * DCACHE_WAYS	; 0x60 - LBA per slot, 0xFFFFFFFF - empty
+.fdpt:			resb 16		; 0x460 - INT 41h table built by the POST
+.timeline:		resb timeline_size	; 0x470 - POST timeline
+.memmap_count:		resb 1		; 0x510 - E820 entries used
+			resb 1
+.ext_kb:		resw 1		; 0x512 - tested KB from 1 MB up (INT 15h 88h/8Ah/E801h)
+			resd 3
+.memmap:		resb MEMMAP_ENTRIES * MEMMAP_ENTRY_SIZE	; 0x520 - E820 entries
+.serial:		resb SERIAL_PORTS * serial_size	; 0x5C0 - COM1, COM2
+.profile:		resb profile_size	; 0xFE0 - NMI profiler
+endstruc
+
+; Read-ahead buffer, only allocated while the disk cache is enabled
+%define EBDA_DCACHE_BUFFER	ebda_size
@@ -0,0 +1,396 @@
+; Disk read cache
+;
+; Set-associative, LBA tagged sector cache kept in the SRAM at DCACHE_BASE.
+; Tags and counters live in the EBDA, sector data is moved with xmem_copy.
+; Reads fill the cache and read ahead past missed requests, writes go
+; through to the drive and drop the cached copies
+;
+
+; dcache_check
+; Checks if the disk cache is enabled
+; Out:
+;   CF = 0 - enabled, FS = EBDA segment
+;   CF = 1 - disabled
+dcache_check:
+	push ax
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+	mov ax, [ebda_segment]
+	pop ds
+	or ax, ax
+	jz dcache_check_off
+	mov fs, ax
+	cmp byte [fs:ebda.dcache_enabled], 0
+	je dcache_check_off
+	pop ax
+	clc
+	ret
+dcache_check_off:
+	pop ax
+	stc
+	ret
+
+
+; dcache_active
+; Checks if requests can be served from the cache
+; Out:
+;   CF = 0 - cache enabled and usable
+;   CF = 1 - cache disabled, or the CPU is in virtual 8086 mode
+dcache_active:
+	push fs
+	push ax
+	call dcache_check
+	jc dcache_active_done
+	smsw ax
+	shr al, 1 ; CF = PE
+dcache_active_done:
+	pop ax
+	pop fs
+	ret
+
+
+; dcache_lookup
+; Finds the slot of a sector
+; In:
+;   EAX - LBA
+;   FS - EBDA segment
+; Out:
+;   CF = 0 - hit, DI - tag offset of the slot (slot * 4)
+;   CF = 1 - miss, DI - tag offset of the slot to replace
+dcache_lookup:
+	push bx
+	push cx
+	mov bx, ax
+	and bx, DCACHE_SETS - 1
+	mov di, bx
+	shl di, 4 ; DCACHE_WAYS tags of 4 bytes per set
+	mov cx, DCACHE_WAYS
+dcache_lookup_loop:
+	cmp [fs:ebda.dcache_tags + di], eax
+	je dcache_lookup_hit
+	add di, 4
+	loop dcache_lookup_loop
+
+	; miss, ways are replaced round robin
+	sub di, DCACHE_WAYS * 4
+	movzx cx, byte [fs:ebda.dcache_next + bx]
+	shl cx, 2
+	add di, cx
+	stc
+	jmp dcache_lookup_done
+dcache_lookup_hit:
+	clc
+dcache_lookup_done:
+	pop cx
+	pop bx
+	ret
+
+
+; dcache_insert
+; Stores a sector in the cache, unless it is already cached
+; In:
+;   EAX - LBA
+;   ESI - linear address of the sector data
+;   FS - EBDA segment
+dcache_insert:
+	push bx
+	push ecx
+	push edi
+	call dcache_lookup
+	jnc dcache_insert_done
+
+	mov bx, ax
+	and bx, DCACHE_SETS - 1
+	inc byte [fs:ebda.dcache_next + bx]
+	and byte [fs:ebda.dcache_next + bx], DCACHE_WAYS - 1
+	mov [fs:ebda.dcache_tags + di], eax
+
+	movzx edi, di
+	shl edi, 7 ; slot * 512
+	add edi, DCACHE_BASE
+	mov ecx, 128
+	call xmem_copy
+dcache_insert_done:
+	pop edi
+	pop ecx
+	pop bx
+	ret
+
+
+; dcache_invalidate
+; Drops the cached copies of sectors
+; In:
+;   EAX - LBA bits 0-31
+;   DX - LBA bits 32-47
+;   CX - number of sectors
+dcache_invalidate:
+	push fs
+	call dcache_check
+	jc dcache_invalidate_exit
+	or dx, dx ; only LBAs below 2^32 are cached
+	jnz dcache_invalidate_exit
+
+	push eax
+	push cx
+	push di
+dcache_invalidate_loop:
+	jcxz dcache_invalidate_done
+	call dcache_lookup
+	jc dcache_invalidate_next
+	mov dword [fs:ebda.dcache_tags + di], 0xFFFFFFFF
+dcache_invalidate_next:
+	inc eax
+	dec cx
+	jmp dcache_invalidate_loop
+dcache_invalidate_done:
+	pop di
+	pop cx
+	pop eax
+dcache_invalidate_exit:
+	pop fs
+	ret
+
+
+; dcache_flush
+; Empties the cache
+; In:
+;   FS - EBDA segment
+dcache_flush:
+	push cx
+	push di
+	xor di, di
+	mov cx, DCACHE_SETS * DCACHE_WAYS
+dcache_flush_loop:
+	mov dword [fs:ebda.dcache_tags + di], 0xFFFFFFFF
+	add di, 4
+	loop dcache_flush_loop
+	pop di
+	pop cx
+	ret
+
+
+; dcache_readahead
+; Reads the sectors following a missed request into the cache
+; In:
+;   EAX - first LBA to read
+;   FS - EBDA segment
+dcache_readahead:
+	pushad
+	push es
+	push ds
+
+	; already read ahead before
+	call dcache_lookup
+	jnc dcache_readahead_done
+
+	; stop at the end of the disk
+	mov cx, DCACHE_READAHEAD
+	mov bx, 0x40
+	mov ds, bx
+	cmp dword [ide_sectors + 4], 0
+	jne dcache_readahead_read
+	mov ebx, [ide_sectors]
+	sub ebx, eax
+	jbe dcache_readahead_done
+	cmp ebx, DCACHE_READAHEAD
+	jae dcache_readahead_read
+	mov cx, bx
+
+dcache_readahead_read:
+	push fs
+	pop es
+	mov bx, EBDA_DCACHE_BUFFER
+	push eax
+	xor dx, dx
+	mov si, IDE_OP_READ
+	call ide_xfer_lba ; CX = sectors read, errors end the read-ahead
+	pop eax
+
+	; ESI = linear address of the buffer
+	xor esi, esi
+	mov si, fs
+	shl esi, 4
+	add esi, EBDA_DCACHE_BUFFER
+dcache_readahead_insert:
+	jcxz dcache_readahead_done
+	call dcache_insert
+	inc eax
+	add esi, 512
+	dec cx
+	jmp dcache_readahead_insert
+
+dcache_readahead_done:
+	pop ds
+	pop es
+	popad
+	ret
+
+
+; dcache_read
+; Reads sectors through the cache
+; Hits are copied from the cache, runs of missed sectors are read from the
+; drive straight into the buffer and then stored in the cache
+; In:
+;   EAX - LBA bits 0-31
+;   DX - LBA bits 32-47
+;   CX - number of sectors
+;   ES:BX - buffer
+; Out:
+;   CF = 0 - ok, AH = 0
+;   CF = 1 - error, AH = int 13h status
+;   CX - number of sectors transferred
+dcache_read:
+	call dcache_active
+	jc ide_xfer_lba
+	or dx, dx ; only LBAs below 2^32 are cached
+	jnz ide_xfer_lba
+
+	push bp
+	mov bp, sp
+	push cx    ; [bp-2] sectors requested
+	push word 0 ; [bp-4] h - status, l - last sector was a miss
+	push fs
+	push es
+	push ebx
+	push edx
+	push esi
+	push edi
+	push eax
+
+	call dcache_check ; FS = EBDA
+
+	; EDX = linear address of the buffer
+	xor edx, edx
+	mov dx, es
+	shl edx, 4
+	movzx ebx, bx
+	add edx, ebx
+
+dcache_read_loop:
+	jcxz dcache_read_done
+	call dcache_lookup
+	jc dcache_read_miss
+
+	; hit, copy the slot to the buffer
+	inc dword [fs:ebda.dcache_hits]
+	mov byte [bp-4], 0
+	movzx esi, di
+	shl esi, 7 ; slot * 512
+	add esi, DCACHE_BASE
+	mov edi, edx
+	push ecx
+	mov ecx, 128
+	call xmem_copy
+	pop ecx
+	inc eax
+	add edx, 512
+	dec cx
+	jmp dcache_read_loop
+
+dcache_read_miss:
+	; length of the run of missed sectors
+	push eax
+	xor bx, bx
+dcache_read_run:
+	inc bx
+	inc eax
+	cmp bx, cx
+	je dcache_read_run_end
+	call dcache_lookup
+	jc dcache_read_run
+dcache_read_run_end:
+	pop eax
+
+	push cx
+	movzx ecx, bx
+	add [fs:ebda.dcache_misses], ecx
+
+	; ES:BX = buffer, segment at most 0xFFFF (buffers in the HMA)
+	mov ebx, edx
+	shr ebx, 4
+	cmp ebx, 0xFFFF
+	jbe dcache_read_segment
+	mov bx, 0xFFFF
+dcache_read_segment:
+	mov es, bx
+	movzx ebx, bx
+	shl ebx, 4
+	neg ebx
+	add ebx, edx
+
+	push eax
+	push edx
+	xor dx, dx
+	mov si, IDE_OP_READ
+	call ide_xfer_lba ; CX = sectors read
+	pop edx
+	mov [bp-3], ah
+	pop eax
+	mov byte [bp-4], 1
+
+	; store what was read
+	pushf
+	mov bx, cx
+	mov esi, edx
+dcache_read_store:
+	jcxz dcache_read_stored
+	call dcache_insert
+	inc eax
+	add esi, 512
+	dec cx
+	jmp dcache_read_store
+dcache_read_stored:
+	mov edx, esi
+	mov cx, bx
+	popf
+	pop bx ; sectors left before the run
+	jc dcache_read_error
+	sub bx, cx
+	mov cx, bx
+	jmp dcache_read_loop
+
+dcache_read_error:
+	sub bx, cx ; sectors left
+	mov cx, [bp-2]
+	sub cx, bx
+	mov ah, [bp-3]
+	stc
+	jmp dcache_read_exit
+
+dcache_read_done:
+	; sequential access, fill the cache past the request
+	cmp byte [bp-4], 0
+	je dcache_read_ok
+	call dcache_readahead
+dcache_read_ok:
+	mov cx, [bp-2]
+	xor ah, ah
+	clc
+
+dcache_read_exit:
+	mov [bp-3], ah
+	pop eax
+	mov ah, [bp-3]
+	pop edi
+	pop esi
+	pop edx
+	pop ebx
+	pop es
+	pop fs
+	mov sp, bp
+	pop bp
+	ret
+
+
+; dcache_xfer
+; ide_xfer_lba through the disk cache
+; In / Out:
+;   see ide_xfer_lba
+dcache_xfer:
+	cmp si, IDE_OP_READ
+	je dcache_read
+	cmp si, IDE_OP_WRITE
+	jne ide_xfer_lba
+	call dcache_invalidate
+	jmp ide_xfer_lba
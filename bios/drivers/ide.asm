@@ -1,12 +1,31 @@
 ; Compact IDE HDD driver (poll-mode)
 ;
-; TODO: implement LBA writes and fix CF cards access
+; TODO: fix CF cards access
 ;
 
 %define IDE_HDD_READ		0x20
 %define IDE_HDD_WRITE		0x30
-
+%define IDE_HDD_READ_MULTIPLE	0xC4
+%define IDE_HDD_WRITE_MULTIPLE	0xC5
+%define IDE_HDD_VERIFY		0x40
+%define IDE_HDD_READ_EXT	0x24
+%define IDE_HDD_READ_MULTIPLE_EXT	0x29
+%define IDE_HDD_WRITE_EXT	0x34
+%define IDE_HDD_WRITE_MULTIPLE_EXT	0x39
+%define IDE_HDD_VERIFY_EXT	0x42
+
+%define IDE_OP_READ		0
+%define IDE_OP_WRITE		1
+%define IDE_OP_VERIFY		2
+
+%define IDE_FLAG_LBA		0x01 ; ide_flags, see c_src/bda.h
+%define IDE_FLAG_LBA48		0x02
+%define IDE_FLAG_IORDY		0x04
+
+%define IDE_STATUS_BSY		0x80
+%define IDE_STATUS_RDY		0x40
 %define IDE_STATUS_DRQ		0x08
+%define IDE_STATUS_ERR		0x01
 
 %define IDE_PORT_DATA		0x1F0
 %define IDE_PORT_COUNT		0x1F2
@@ -167,10 +186,16 @@ ide_wait:
     mov dx, IDE_PORT_STATUS
 ide_wait_loop:
     in al, dx
+    test al, IDE_STATUS_BSY
+    jnz ide_wait_next
+    test al, IDE_STATUS_ERR
+    jnz ide_wait_error
     test al, IDE_STATUS_DRQ
     jnz ide_wait_ok
+ide_wait_next:
     dec ecx
     jnz ide_wait_loop
+ide_wait_error:
     stc
     jmp ide_wait_done
 ide_wait_ok:
@@ -182,167 +207,497 @@ ide_wait_done:
     ret
 
 
-ide_check_lba: ; Get Extended Drive Parameters
-    ; DL - drive (0x80)
-    ; BX = 55AAh
-    ; check dl is 0x80
+; ide_pio_read / ide_pio_write
+; Moves words between the IDE data port and memory with rep insw / rep outsw
+; The buffer is normalized before every chunk, so the transfer continues
+; linearly in memory when it crosses a 64 KB segment wrap
+; In:
+;   CX - number of words
+;   ES:BX - buffer
+; Out:
+;   ES:BX - points past the transferred data (normalized)
+ide_pio_read:
+	push ax
+	mov al, 0
+	jmp ide_pio_transfer
+ide_pio_write:
+	push ax
+	mov al, 1
+ide_pio_transfer:
+	push cx
+	push dx
+	push si
+	push di
+	mov dx, IDE_PORT_DATA
+ide_pio_chunk:
+	; ES:BX -> ES:000x, chunk below can't reach the segment end
+	mov si, bx
+	shr si, 4
+	mov di, es
+	add di, si
+	mov es, di
+	and bx, 0x000F
+
+	; at most 32 KB per chunk
+	mov si, cx
+	cmp si, 0x4000
+	jbe ide_pio_chunk_size
+	mov si, 0x4000
+ide_pio_chunk_size:
+	sub cx, si
+	push cx
+	mov cx, si
+
+	cmp al, 0
+	jne ide_pio_chunk_out
+	mov di, bx
+	rep insw
+	mov bx, di
+	jmp ide_pio_chunk_done
+ide_pio_chunk_out:
+	push ds
+	push es
+	pop ds
+	mov si, bx
+	rep outsw
+	mov bx, si
+	pop ds
+ide_pio_chunk_done:
+	pop cx
+	or cx, cx
+	jnz ide_pio_chunk
+
+	pop di
+	pop si
+	pop dx
+	pop cx
+	pop ax
+	ret
+
+
+; ide_block_size
+; Returns the number of sectors the drive transfers per DRQ
+; READ/WRITE MULTIPLE block size is negotiated by the C POST
+; In:
+;   none
+; Out:
+;   AH - sectors per block (1 if READ/WRITE MULTIPLE is disabled)
+ide_block_size:
+	push ds
+	push bx
+	mov bx, 0x40
+	mov ds, bx
+	mov ah, [ide_multiple]
+	pop bx
+	pop ds
+	cmp ah, 1
+	ja ide_block_size_done
+	mov ah, 1
+ide_block_size_done:
+	ret
+
+
+; ide_check_lba
+; Reports EDD support (int 13h AH=41h)
+; In:
+;   DL - drive (0x80)
+; Out:
+;   CF = 0 - supported, AH = EDD version, BX = 0xAA55, CX = API subset bitmap
+;   CF = 1 - not supported (reporting off in setup or a CHS only drive)
+ide_check_lba:
     cmp dl, 0x80
     jne .not_supported
 
-	; Check if LBA support reporting is enabled (bit 1 of CMOS 0x40)
-	push ax 
-	pushf
-	in al, 0x70
-	mov ah, al ; old index to AH
-	mov al, 0x40
-	out 0x70, al
-	in al, 0x71
-	test al, 0b00000010
-	jz .not_supported_cmos_res ; jump if zero
-	mov al, ah
-	out 0x70, al
-	popf
+	; Check if LBA support reporting is enabled (settings snapshot)
+	; and the drive takes LBA addresses
+	push ds
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	test byte [bios_settings], 0x01
+	jz .checked
+	test byte [ide_flags], IDE_FLAG_LBA
+.checked:
 	pop ax
+	pop ds
+	jz .not_supported
 
 
     mov bx, 0xAA55
-    mov ah, 0x20 ; success
-    mov cx, 1 ; int 13,42h supported
+    mov ah, 0x30 ; EDD 3.0
+    mov cx, 0x0005 ; AH=42h-44h,47h,48h and EDD (AH=48h) supported
     clc
     ret
 
-.not_supported_cmos_res:
-	mov al, ah
-	out 0x70, al
-	popf
-	pop ax
 .not_supported:
 	stc
 	ret
 
 
-; Extended Read Sectors From Drive (LBA)
-; DL - drive (0x80)
-; DS:SI - pointer to packet structure
-; Packet structure:
-; Offset Size Description
-; 0      1    Size of packet (10h)
-; 1      1    Reserved (must be 0)
-; 2      2    Number of blocks to transfer
-; 4      2    Buffer offset
-; 6      2    Buffer segment
-; 8      8    Starting LBA (QWORD). We will only use lower DWORD for now (offset 8)
-ide_read_lba: 
-	pusha
-    pushf
-    push es
-
-	mov ax, [ds:si]
-    cmp al, 0x10
-    jne .packet_error
-
-    ; wait for drive ready (BSY[7]=0, RDY[6]=1)
-.wait_ready42:
-    mov dx, IDE_PORT_STATUS
-    in al, dx
-    and al, 0xC0
-    cmp al, 0x40
-    jne .wait_ready42
-
-    mov dx, IDE_PORT_HEAD_DRV_LBA ; select 
-    mov al, 0xE0
-    out dx, al ; select drive (master)
-
-	mov dx, 0x80 ; io wait
+; ide_wait_ready
+; Waits until the selected drive is not busy and can accept a command
+; Out:
+;   CF = 0 - ok
+;   CF = 1 - timeout, AH = 0x80
+ide_wait_ready:
+	push ecx
+	push dx
+	mov ecx, 2000000
+	mov dx, IDE_PORT_STATUS
+ide_wait_ready_loop:
 	in al, dx
+	and al, IDE_STATUS_BSY | IDE_STATUS_RDY
+	cmp al, IDE_STATUS_RDY
+	je ide_wait_ready_ok
+	dec ecx
+	jnz ide_wait_ready_loop
+	mov ah, 0x80 ; timeout
+	stc
+	jmp ide_wait_ready_done
+ide_wait_ready_ok:
+	clc
+ide_wait_ready_done:
+	pop dx
+	pop ecx
+	ret
 
-    ; set sector count (number of sectors to read)
-    mov dx, IDE_PORT_COUNT
-    mov al, [ds:si + 2] ; number of blocks to transfer
-    out dx, al
 
-	mov dx, 0x80 ; io wait
+; ide_wait_done
+; Waits until the drive finishes a command without a data phase (or the last
+; block of a write) and checks its status
+; Out:
+;   CF = 0 - ok
+;   CF = 1 - error, AH = int 13h status
+ide_wait_done:
+	push ecx
+	push dx
+	mov ecx, 2000000
+	mov dx, IDE_PORT_STATUS
+ide_wait_done_loop:
 	in al, dx
+	test al, IDE_STATUS_BSY
+	jz ide_wait_done_check
+	dec ecx
+	jnz ide_wait_done_loop
+ide_wait_done_check:
+	call ide_error_code
+	test al, IDE_STATUS_BSY | IDE_STATUS_ERR
+	jz ide_wait_done_ok
+	stc
+	jmp ide_wait_done_exit
+ide_wait_done_ok:
+	clc
+ide_wait_done_exit:
+	pop dx
+	pop ecx
+	ret
 
-    ; We will only send 24 bits of LBA
-    mov dx, IDE_PORT_SECTOR
-    mov al, [ds:si + 8]     ; LBA bits 0-7
-    out dx, al
 
-	mov dx, 0x80 ; io wait
+; ide_error_code
+; Converts the drive status to an int 13h status after a failed wait
+; Out:
+;   AL - drive status
+;   AH - 0x80 (timeout) if the drive is still busy, 0xE0 (status error) otherwise
+ide_error_code:
+	push dx
+	mov dx, IDE_PORT_STATUS
 	in al, dx
+	pop dx
+	mov ah, 0x80
+	test al, IDE_STATUS_BSY
+	jnz ide_error_code_done
+	mov ah, 0xE0
+ide_error_code_done:
+	ret
 
-    mov dx, IDE_PORT_CYL_LOW
-    mov al, [ds:si + 9]     ; LBA bits 8-15
-    out dx, al
 
-	mov dx, 0x80 ; io wait
-	in al, dx
+; Commands indexed by operation * 4 + 48-bit * 2 + block mode
+ide_lba_commands:
+	db IDE_HDD_READ, IDE_HDD_READ_MULTIPLE, IDE_HDD_READ_EXT, IDE_HDD_READ_MULTIPLE_EXT
+	db IDE_HDD_WRITE, IDE_HDD_WRITE_MULTIPLE, IDE_HDD_WRITE_EXT, IDE_HDD_WRITE_MULTIPLE_EXT
+	db IDE_HDD_VERIFY, IDE_HDD_VERIFY, IDE_HDD_VERIFY_EXT, IDE_HDD_VERIFY_EXT
 
-    mov dx, IDE_PORT_CYL_HIGH
-    mov al, [ds:si + 10]    ; LBA bits 16-23
-    out dx, al
+; ide_xfer_lba
+; Reads, writes or verifies sectors addressed by LBA
+; Transfers are split into commands of at most 256 sectors. 28-bit commands
+; are used while a command stays below sector 2^28, 48-bit ones above it
+; In:
+;   EAX - LBA bits 0-31
+;   DX - LBA bits 32-47
+;   CX - number of sectors
+;   SI - operation (IDE_OP_READ, IDE_OP_WRITE, IDE_OP_VERIFY)
+;   ES:BX - buffer
+; Out:
+;   CF = 0 - ok, AH = 0
+;   CF = 1 - error, AH = int 13h status
+;   CX - number of sectors transferred
+ide_xfer_lba:
+	push bp
+	mov bp, sp
+	sub sp, 16 ; stack frame size
+
+	mov [bp-4], eax  ; LBA bits 0-31
+	mov [bp-6], dx   ; LBA bits 32-47
+	mov [bp-8], cx   ; sectors left
+	mov word [bp-10], 0 ; sectors done
+	mov [bp-12], si  ; operation
+	call ide_block_size
+	mov al, ah
+	xor ah, ah
+	mov [bp-16], ax  ; sectors per block
+
+	push es
+	push bx
+	push edx
+	push di
+
+ide_xfer_next:
+	mov cx, [bp-8]
+	jcxz ide_xfer_ok
+	cmp cx, 256
+	jbe ide_xfer_chunk
+	mov cx, 256
+ide_xfer_chunk:
+	mov [bp-14], cx  ; sectors in this command
+
+	; 48-bit command if the last sector of the chunk is at or above 2^28
+	xor di, di
+	mov eax, [bp-4]
+	movzx edx, cx
+	dec edx
+	add eax, edx
+	mov dx, [bp-6]
+	adc dx, 0
+	jnz ide_xfer_lba48
+	cmp eax, 0x0FFFFFFF
+	jbe ide_xfer_select
+ide_xfer_lba48:
+	push ds
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	test byte [ide_flags], IDE_FLAG_LBA48
+	pop ax
+	pop ds
+	jz ide_xfer_range
+	mov di, 2
+
+ide_xfer_select:
+	; select master, LBA bits 24-27 for 28-bit commands
+	mov al, 0
+	or di, di
+	jnz ide_xfer_select_drive
+	mov al, [bp-1]
+	and al, 0x0F
+ide_xfer_select_drive:
+	or al, 0xE0
+	mov dx, IDE_PORT_HEAD_DRV_LBA
+	out dx, al
 
 	mov dx, 0x80 ; io wait
 	in al, dx
 
+	call ide_wait_ready
+	jc ide_xfer_fail
 
-    ; issue read command (0x20)
-    mov al, 0x20
-    mov dx, IDE_PORT_CMD
-    out dx, al
-
-	xor cx, cx
-    mov cl, [ds:si + 2] ; number of blocks to transfer
-    mov dx, 0x1F0 ; data port
-    ; get buffer segment:offset
-    mov bx, [ds:si + 4] ; offset
-    mov es, [ds:si + 6] ; segment
-
-.read_loop42:
-	; wait for DRQ=1 (bit 3)
-	push dx
-.wait_drq42:
-	mov dx, 0x80 ; io wait
-	in al, dx
-	mov dx, IDE_PORT_STATUS
-    in al, dx
-	and al, 0b00001000
-	cmp al, 0b00001000
-	jne .wait_drq42
-	
-	pop dx
-
-    push cx ; use cx as block counter, but save it as we use cx for word count too
-    mov cx, 256 ; word counter
-.read_loop_words42:
-    in word ax, dx
-    mov [es:bx], ax
-    add bx, 2
-    dec cx
-    jnz .read_loop_words42
+	or di, di
+	jz ide_xfer_regs
+	; 48-bit: high order bytes first
+	mov dx, IDE_PORT_COUNT
+	mov al, ch
+	out dx, al
+	mov dx, IDE_PORT_SECTOR
+	mov al, [bp-1]
+	out dx, al
+	mov dx, IDE_PORT_CYL_LOW
+	mov al, [bp-6]
+	out dx, al
+	mov dx, IDE_PORT_CYL_HIGH
+	mov al, [bp-5]
+	out dx, al
+ide_xfer_regs:
+	mov dx, IDE_PORT_COUNT
+	mov al, cl ; 256 sectors = 0
+	out dx, al
+	mov dx, IDE_PORT_SECTOR
+	mov al, [bp-4]
+	out dx, al
+	mov dx, IDE_PORT_CYL_LOW
+	mov al, [bp-3]
+	out dx, al
+	mov dx, IDE_PORT_CYL_HIGH
+	mov al, [bp-2]
+	out dx, al
 
-    pop cx ; restore block counter and decrement
-    dec cx ; block count
-    jnz .read_loop42
+	; command = ide_lba_commands[op * 4 + 48-bit * 2 + block mode]
+	mov ax, [bp-12]
+	shl ax, 2
+	add di, ax
+	cmp word [bp-16], 1
+	je ide_xfer_cmd
+	inc di
+ide_xfer_cmd:
+	mov al, [cs:ide_lba_commands + di]
+	mov dx, IDE_PORT_CMD
+	out dx, al
 
+	cmp byte [bp-12], IDE_OP_VERIFY
+	je ide_xfer_wait
+
+ide_xfer_block:
+	call ide_wait ; one DRQ per block
+	jc ide_xfer_status
+	; sectors in this block = min(block size, sectors left in command)
+	mov dx, [bp-16]
+	cmp dx, cx
+	jbe ide_xfer_block_size
+	mov dx, cx
+ide_xfer_block_size:
+	sub cx, dx
+	push cx
+	mov cx, dx
+	shl cx, 8 ; CX = sectors * 256 words
+	cmp byte [bp-12], IDE_OP_WRITE
+	je ide_xfer_block_write
+	call ide_pio_read
+	jmp ide_xfer_block_done
+ide_xfer_block_write:
+	call ide_pio_write
+ide_xfer_block_done:
+	pop cx
+	or cx, cx
+	jnz ide_xfer_block
+
+	cmp byte [bp-12], IDE_OP_READ
+	je ide_xfer_advance
+ide_xfer_wait:
+	; verify, or the drive is still writing the last block
+	call ide_wait_done
+	jc ide_xfer_fail
+
+ide_xfer_advance:
+	mov cx, [bp-14]
+	add [bp-10], cx
+	sub [bp-8], cx
+	movzx ecx, cx
+	add [bp-4], ecx
+	adc word [bp-6], 0
+	jmp ide_xfer_next
+
+ide_xfer_ok:
+	xor ah, ah
+	clc
+	jmp ide_xfer_exit
+ide_xfer_range:
+	mov ah, 0x01 ; no 48-bit LBA, invalid parameter
+	jmp ide_xfer_fail
+ide_xfer_status:
+	call ide_error_code
+ide_xfer_fail:
+	stc
+ide_xfer_exit:
+	mov cx, [bp-10]
+	pop di
+	pop edx
+	pop bx
 	pop es
-    popf
-    popa
+	mov sp, bp
+	pop bp
+	ret
 
-    clc
-    mov ah, 0 ; success
-    ret
-
-.packet_error:
-    pop es
-    popf
-    popa
-	mov ah, 0x01 ; invalid parameter
-    ret
 
+; ide_drive_params
+; Fills the EDD drive parameter table (int 13h AH=48h)
+; In:
+;   DS:SI - result buffer, word 0 = buffer size
+; Out:
+;   CF = 0 - ok
+;   CF = 1 - buffer too small, AH = 0x01
+ide_drive_params:
+	push es
+	push eax
+	push bx
+	push cx
 
+	mov bx, 0x40
+	mov es, bx
+
+	mov cx, [ds:si]
+	cmp cx, 0x1A
+	jb ide_drive_params_error
+
+	mov word [ds:si], 0x1A
+	mov word [ds:si + 0x02], 0x0002 ; CHS information is valid
+	movzx eax, word [es:ide_cylinders]
+	mov [ds:si + 0x04], eax
+	movzx eax, byte [es:ide_heads]
+	mov [ds:si + 0x08], eax
+	movzx eax, byte [es:ide_spt]
+	mov [ds:si + 0x0C], eax
+
+	; not valid when the geometry does not cover the whole drive
+	imul eax, [ds:si + 0x08]
+	imul eax, [ds:si + 0x04]
+	cmp dword [es:ide_sectors + 4], 0
+	jne ide_drive_params_no_chs
+	cmp eax, [es:ide_sectors]
+	jae ide_drive_params_chs
+ide_drive_params_no_chs:
+	mov word [ds:si + 0x02], 0
+ide_drive_params_chs:
+	mov eax, [es:ide_sectors]
+	mov [ds:si + 0x10], eax
+	mov eax, [es:ide_sectors + 4]
+	mov [ds:si + 0x14], eax
+	mov word [ds:si + 0x18], 512 ; bytes per sector
+
+	; EDD 2.0: no DPTE
+	cmp cx, 0x1E
+	jb ide_drive_params_done
+	mov word [ds:si], 0x1E
+	mov dword [ds:si + 0x1A], 0xFFFFFFFF
+
+	; EDD 3.0: device path, primary ISA channel, master
+	cmp cx, 0x42
+	jb ide_drive_params_done
+	mov word [ds:si], 0x42
+	mov word [ds:si + 0x1E], 0xBEDD ; key
+	mov dword [ds:si + 0x20], 0x24 ; length, 3 reserved bytes
+	mov dword [ds:si + 0x24], 'ISA '
+	mov dword [ds:si + 0x28], 'ATA '
+	mov dword [ds:si + 0x2C], '    '
+	mov dword [ds:si + 0x30], IDE_PORT_DATA ; interface path: base address
+	mov dword [ds:si + 0x34], 0
+	mov dword [ds:si + 0x38], 0 ; device path: master
+	mov dword [ds:si + 0x3C], 0
+	mov word [ds:si + 0x40], 0
+	; checksum of 0x1E-0x41
+	xor al, al
+	mov bx, 0x1E
+ide_drive_params_sum:
+	add al, [ds:si + bx]
+	inc bx
+	cmp bx, 0x41
+	jb ide_drive_params_sum
+	neg al
+	mov [ds:si + 0x41], al
+
+ide_drive_params_done:
+	pop cx
+	pop bx
+	pop eax
+	pop es
+	clc
+	ret
 
+ide_drive_params_error:
+	pop cx
+	pop bx
+	pop eax
+	pop es
+	mov ah, 0x01
+	stc
+	ret
 
 
 ; ide_read
@@ -355,37 +710,43 @@ ide_read_lba:
 ;   DL - drive number
 ;   ES:BX - buffer
 ide_read:
+	push es
 	push ax
 
 	call ide_send_chs
 
-	; send read command
+	; send read command, READ MULTIPLE if block mode is enabled
+	call ide_block_size
 	mov al, IDE_HDD_READ
+	cmp ah, 1
+	je ide_read_cmd
+	mov al, IDE_HDD_READ_MULTIPLE
+ide_read_cmd:
 	mov dx, IDE_PORT_CMD
 	out dx, al
 
-	pop ax
+	pop dx
+	mov al, dl ; AL = sectors left, AH = sectors per block
 
 ide_read_loop:
 	or al, al
 	jz ide_read_done
-	call ide_wait
+	call ide_wait ; one DRQ per block
 	jc ide_read_timeout
-	mov cx, 256
-	mov dx, IDE_PORT_DATA
-	push ax
-ide_read_data:
-	in ax, dx
-	mov [es:bx], ax
-	add bx, 2
-	loop ide_read_data
-	pop ax
-	sub al, 1
+	mov cl, ah
+	cmp cl, al
+	jbe ide_read_block
+	mov cl, al
+ide_read_block:
+	sub al, cl
+	xor ch, ch
+	xchg cl, ch ; CX = sectors * 256 words
+	call ide_pio_read
 	jmp ide_read_loop
 ide_read_done:
 	clc
-	ret
 ide_read_timeout:
+	pop es
 	ret
 
 ; ide_write
@@ -398,35 +759,41 @@ ide_read_timeout:
 ;   DL - drive number
 ;   ES:BX - buffer
 ide_write:
+	push es
 	push ax
 
 	call ide_send_chs
 
-	; send write command
+	; send write command, WRITE MULTIPLE if block mode is enabled
+	call ide_block_size
 	mov al, IDE_HDD_WRITE
+	cmp ah, 1
+	je ide_write_cmd
+	mov al, IDE_HDD_WRITE_MULTIPLE
+ide_write_cmd:
 	mov dx, IDE_PORT_CMD
 	out dx, al
 
-	pop ax
+	pop dx
+	mov al, dl ; AL = sectors left, AH = sectors per block
 
 ide_write_loop:
 	or al, al
 	jz ide_write_done
-	call ide_wait
+	call ide_wait ; one DRQ per block
 	jc ide_write_timeout
-	mov cx, 256
-	mov dx, IDE_PORT_DATA
-	push ax
-ide_write_data:
-	mov ax, [es:bx]
-	out dx, ax
-	add bx, 2
-	loop ide_write_data
-	pop ax
-	sub al, 1
+	mov cl, ah
+	cmp cl, al
+	jbe ide_write_block
+	mov cl, al
+ide_write_block:
+	sub al, cl
+	xor ch, ch
+	xchg cl, ch ; CX = sectors * 256 words
+	call ide_pio_write
 	jmp ide_write_loop
 ide_write_done:
 	clc
-	ret
 ide_write_timeout:
+	pop es
 	ret
@@ -0,0 +1,46 @@
+;
+; Linux kernel start
+;
+; The C POST (c_src/linux.c) loads the kernel from the disk and sets
+; post_flags bit 1. The real-mode setup code is then started in place of the
+; boot sector, it asks INT 15h for the memory and switches to the kernel itself
+;
+
+%define LINUX_SETUP_SEG	0x9000	; LINUX_SETUP_ADDR in c_src/linux.h
+%define LINUX_HEAP_END	0x9800
+
+; linux_boot_check
+; Called in place of printing the boot sector message
+; In:
+;   CS:SI - boot sector message
+; Out:
+;   returns only when no kernel was loaded, after printing the message
+linux_boot_check:
+	push ds
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	test byte [post_flags], 0x02
+	pop ax
+	pop ds
+	jz putsv
+
+	mov si, msg_linux
+	call putsv
+	mov al, 0x0B ; POST 0x0B - INT 19h handoff
+	call post_mark
+
+	; Same state as the boot sector gets
+	cli
+	mov ax, LINUX_SETUP_SEG
+	mov ds, ax
+	mov es, ax
+	mov fs, ax
+	mov gs, ax
+	mov ss, ax
+	mov sp, LINUX_HEAP_END
+	sti
+	jmp (LINUX_SETUP_SEG + 0x20):0x0000
+
+msg_linux:
+	db "Starting Linux kernel...", 13, 10, 0
@@ -0,0 +1,140 @@
+;
+; NMI sampling profiler
+;
+; The chipset NMI timer (CMOS registers 0xF8-0xFA, chipset version 0002)
+; interrupts the CPU every period PIT clocks and profile_nmi stores the
+; interrupted CS:IP in the EBDA ring. The ring is reserved by the POST only
+; with the setup option on, profile.entries is 0 otherwise
+; Controlled by INT 1Ah AH=F1h (isr/int1a_ext.asm), read out by NMIPROF.COM
+; Samples are real mode (or V86 monitor) addresses, protected mode code
+; runs with its own IDT and never gets here
+;
+
+; profile_nmi
+; NMI vector. Takes a sample while profile.active is set, any other NMI is
+; a hardware error and goes to int02. Does not touch port 0x70, the
+; interrupted code may be between an index and a data access
+profile_nmi:
+	push bp
+	mov bp, sp
+	push ax
+	push bx
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+	mov ax, [ebda_segment]
+	test ax, ax
+	jz .error
+	mov ds, ax
+	cmp byte [ebda.profile + profile.active], 0
+	je .error
+
+	inc dword [ebda.profile + profile.count]
+	mov bx, [ebda.profile + profile.head]
+	inc bx
+	cmp bx, [ebda.profile + profile.entries]
+	jb .no_wrap
+	xor bx, bx
+.no_wrap:
+	cmp bx, [ebda.profile + profile.tail]
+	je .full
+	xchg bx, [ebda.profile + profile.head]
+	shl bx, 2
+	add bx, [ebda.profile + profile.ring]
+	mov ax, [bp + 2] ; IP
+	mov [bx], ax
+	mov ax, [bp + 4] ; CS
+	mov [bx + 2], ax
+	jmp .done
+.full:
+	inc dword [ebda.profile + profile.dropped]
+.done:
+	pop ds
+	pop bx
+	pop ax
+	pop bp
+	iret
+.error:
+	pop ds
+	pop bx
+	pop ax
+	pop bp
+	jmp int02
+
+; profile_segment
+; Out:
+;   DS - EBDA segment
+;   CF = 1 - no EBDA or no ring reserved
+profile_segment:
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	mov ax, [ebda_segment]
+	test ax, ax
+	jz .none
+	mov ds, ax
+	cmp word [ebda.profile + profile.entries], 0
+	je .none
+	pop ax
+	clc
+	ret
+.none:
+	pop ax
+	stc
+	ret
+
+; profile_start
+; Empties the ring and starts the chipset timer
+; In:
+;   CX - PIT clocks per sample, 0 - PROFILE_PERIOD
+;   DS - EBDA segment
+profile_start:
+	push ax
+	call profile_stop
+	xor ax, ax
+	mov [ebda.profile + profile.head], ax
+	mov [ebda.profile + profile.tail], ax
+	mov [ebda.profile + profile.dropped], ax
+	mov [ebda.profile + profile.dropped + 2], ax
+	mov [ebda.profile + profile.count], ax
+	mov [ebda.profile + profile.count + 2], ax
+	mov byte [ebda.profile + profile.active], 1
+
+	pushf
+	cli
+	mov al, 0xF9
+	out 0x70, al
+	mov ax, cx
+	test ax, ax
+	jnz .period
+	mov ax, PROFILE_PERIOD
+.period:
+	out 0x71, al
+	mov al, 0xFA
+	out 0x70, al
+	mov al, ah
+	out 0x71, al
+	mov al, 0xF8
+	out 0x70, al
+	mov al, 0x01
+	out 0x71, al
+	popf
+	pop ax
+	ret
+
+; profile_stop
+; Stops the chipset timer, the samples stay in the ring
+; In:
+;   DS - EBDA segment
+profile_stop:
+	push ax
+	pushf
+	cli
+	mov al, 0xF8
+	out 0x70, al
+	xor al, al
+	out 0x71, al
+	popf
+	mov byte [ebda.profile + profile.active], 0
+	pop ax
+	ret
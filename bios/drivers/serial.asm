@@ -0,0 +1,254 @@
+;
+; Serial ports
+;
+; COM1 (IRQ4) and COM2 (IRQ3) become interrupt driven once INT 14h AH=00h/04h
+; sets them up: received bytes go to a ring buffer in the EBDA and queued
+; bytes are moved to the UART by the IRQ. A 16550A FIFO is enabled when
+; found. COM3/COM4, or any port before the C POST placed the EBDA, stay polled
+;
+
+; serial_port
+; In:
+;   DX - port index, 0 - COM1
+;   DS = 0x40
+; Out:
+;   CF = 0 - DX = I/O base, SI = ring buffer state in the EBDA at FS (0 - polled port)
+;   CF = 1 - no such port
+serial_port:
+	cmp dx, 3
+	ja .none
+	mov si, dx
+	shl si, 1
+	mov dx, [bios_data + si] ; COM port table
+	test dx, dx
+	jz .none
+	cmp si, 2
+	ja .polled
+	push ax
+	mov ax, [ebda_segment]
+	mov fs, ax
+	test ax, ax
+	pop ax
+	jz .polled
+	imul si, si, serial_size / 2
+	add si, ebda.serial
+	clc
+	ret
+.polled:
+	xor si, si
+	clc
+	ret
+.none:
+	stc
+	ret
+
+; serial_buffered
+; In:
+;   FS:SI - from serial_port
+; Out:
+;   ZF = 1 - polled, the port was not set up by INT 14h AH=00h/04h
+serial_buffered:
+	test si, si
+	jz .done
+	cmp word [fs:si + serial.base], 0
+.done:
+	ret
+
+; serial_setup
+; Programs the UART, detects the FIFO and starts the interrupts
+; In:
+;   AL - line control register
+;   CX - baud rate divisor
+;   DX - I/O base
+;   FS:SI - ring buffer state, SI = 0 - polled port
+; Out:
+;   AH - line status, AL - modem status
+serial_setup:
+	push bx
+	mov bl, al
+	test si, si
+	jz .uart
+	mov word [fs:si + serial.base], 0 ; the IRQ leaves the port alone meanwhile
+.uart:
+	add dx, 3
+	mov al, 0x80 ; DLAB
+	out dx, al
+	sub dx, 3
+	mov al, cl
+	out dx, al
+	inc dx
+	mov al, ch
+	out dx, al
+	add dx, 2
+	mov al, bl
+	out dx, al ; LCR
+
+	dec dx ; FCR
+	mov al, 0xC7 ; FIFO on and cleared, RX interrupt at 14 bytes
+	out dx, al
+	in al, dx ; IIR bits 7-6 are both set only by a working 16550A FIFO
+	and al, 0xC0
+	xor bl, bl
+	cmp al, 0xC0
+	je .fifo
+	xor al, al
+	out dx, al
+	jmp .fifo_done
+.fifo:
+	mov bl, 0x01
+.fifo_done:
+	sub dx, 2
+
+	mov al, 0x03 ; DTR, RTS
+	xor bh, bh ; no interrupts
+	test si, si
+	jz .mcr
+	mov [fs:si + serial.flags], bl
+	mov byte [fs:si + serial.lsr], 0
+	mov dword [fs:si + serial.rx_head], 0 ; and rx_tail
+	mov dword [fs:si + serial.tx_head], 0 ; and tx_tail
+	mov [fs:si + serial.base], dx
+	mov al, 0x0B ; DTR, RTS, OUT2 (IRQ line)
+	mov bh, 0x05 ; received data, line status
+.mcr:
+	add dx, 4
+	out dx, al
+	sub dx, 3
+	mov al, bh
+	out dx, al ; IER
+	dec dx
+	pop bx
+	; fall through
+
+; serial_status
+; In:
+;   DX - I/O base
+; Out:
+;   AH - line status, AL - modem status
+serial_status:
+	push dx
+	add dx, 6
+	in al, dx ; MSR
+	mov ah, al
+	dec dx
+	in al, dx ; LSR
+	xchg al, ah
+	pop dx
+	ret
+
+; serial_tx_start
+; Enables the transmitter empty interrupt, which fires at once if the UART is idle
+; In:
+;   DX - I/O base
+serial_tx_start:
+	push ax
+	inc dx
+	mov al, 0x07 ; received data, transmitter empty, line status
+	out dx, al
+	dec dx
+	pop ax
+	ret
+
+; serial_irq4 / serial_irq3
+; COM1 / COM2 interrupt vectors
+serial_irq4:
+	push si
+	mov si, ebda.serial
+	jmp serial_irq
+serial_irq3:
+	push si
+	mov si, ebda.serial + serial_size
+serial_irq:
+	push ax
+	push bx
+	push dx
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+	mov ax, [ebda_segment]
+	test ax, ax
+	jz .eoi
+	mov ds, ax
+	mov dx, [si + serial.base]
+	test dx, dx
+	jz .eoi
+
+.next:
+	add dx, 2
+	in al, dx ; IIR
+	sub dx, 2
+	test al, 0x01
+	jnz .eoi
+	and al, 0x06
+	cmp al, 0x04
+	je .rx ; also the FIFO timeout
+	cmp al, 0x02
+	je .tx
+	cmp al, 0x06
+	je .line
+	add dx, 6 ; modem status change, reading MSR clears it
+	in al, dx
+	sub dx, 6
+	jmp .next
+
+.line:
+	add dx, 5
+	in al, dx ; LSR
+	sub dx, 5
+	and al, 0x1E ; overrun, parity, framing, break
+	or [si + serial.lsr], al
+	jmp .next
+
+.rx:
+	in al, dx
+	mov bx, [si + serial.rx_head]
+	mov [si + bx + serial.rx], al ; the slot at the head is always free
+	inc bx
+	and bx, SERIAL_RX_SIZE - 1
+	cmp bx, [si + serial.rx_tail]
+	je .rx_full
+	mov [si + serial.rx_head], bx
+	jmp .rx_more
+.rx_full:
+	or byte [si + serial.lsr], 0x02 ; dropped, reported as an overrun
+.rx_more:
+	add dx, 5
+	in al, dx ; LSR
+	sub dx, 5
+	test al, 0x01
+	jnz .rx
+	jmp .next
+
+.tx:
+	mov ah, 1 ; bytes per transmitter empty interrupt
+	test byte [si + serial.flags], 0x01
+	jz .tx_byte
+	mov ah, 16
+.tx_byte:
+	mov bx, [si + serial.tx_tail]
+	cmp bx, [si + serial.tx_head]
+	je .tx_empty
+	mov al, [si + bx + serial.tx]
+	out dx, al
+	inc bx
+	and bx, SERIAL_TX_SIZE - 1
+	mov [si + serial.tx_tail], bx
+	dec ah
+	jnz .tx_byte
+	jmp .next
+.tx_empty:
+	inc dx
+	mov al, 0x05 ; received data, line status
+	out dx, al ; IER
+	dec dx
+	jmp .next
+
+.eoi:
+	mov al, 0x20
+	out 0x20, al
+	pop ds
+	pop dx
+	pop bx
+	pop ax
+	pop si
+	iret
@@ -0,0 +1,266 @@
+;
+; Shadow RAM for the system BIOS and option ROMs
+;
+; Chipset version 0004 can serve 0xC0000 - 0xFFFFF from the SRAM behind
+; the 0x4C0000 - 0x4FFFFF wrap in 16 KB blocks, bit n of CMOS registers
+; 0xF0-0xF1 reads block n from RAM, bit n of 0xF2-0xF3 writes it to RAM.
+; RAM is 32 bit and cacheable, the ROM and the ISA bus are 8 bit.
+; The registers are cleared by a reset, every POST copies the ROMs again.
+; The fast CPU reset resume (drivers/warmboot.asm) only sets them back from
+; shadow_blocks, the RAM copies survive the reset.
+; The C POST keeps the 0x4C0000 alias out of the memory test and E820
+;
+
+%define SHADOW_CHIPSET_VER	0x0004
+%define SHADOW_SYSTEM		0xF000	; blocks of 0xF0000 - 0xFFFFF
+%define SHADOW_OPTION		0x0FFF	; blocks option ROMs may use
+
+; scan_roms
+; Runs the option ROMs at 0xC0000, 0xD0000 and 0xE0000, shadowed when the
+; setup option is on
+; In:
+;   DS = 0x40
+scan_roms:
+	call shadow_system
+	mov word [bios_temp + 2], 0xC000
+	mov word [bios_temp], 2
+.next:
+	mov ax, [bios_temp + 2]
+	mov es, ax
+	cmp [es:0], word 0xAA55
+	jnz .no_rom
+	call shadow_rom
+	call far [bios_temp]
+	mov ax, 0x40
+	mov ds, ax
+	call shadow_protect
+.no_rom:
+	mov ax, 0x40
+	mov ds, ax
+	mov ax, 0x1000
+	add [bios_temp + 2], ax
+	cmp word [bios_temp + 2], 0xF000
+	jnz .next
+	ret
+
+; shadow_system
+; Copies the system BIOS to shadow RAM and write protects it when the
+; "Shadow BIOS and option ROMs" setup option (CMOS 0x40 bit 7) is on
+; In:
+;   DS = 0x40
+shadow_system:
+	push ax
+	push cx
+	push dx
+	; A warm boot does not reset the chipset, start from the ROM again
+	xor ax, ax
+	xor dx, dx
+	call shadow_set
+	mov [shadow_blocks], ax
+
+	mov al, 0xFC
+	call shadow_cmos_read
+	cmp al, 0x48
+	jne .done
+	mov al, 0xFD
+	call shadow_cmos_read
+	cmp al, 0x86
+	jne .done
+	mov al, 0xFE
+	call shadow_cmos_read
+	mov ah, al
+	mov al, 0xFF
+	call shadow_cmos_read
+	cmp ax, SHADOW_CHIPSET_VER
+	jb .done
+	mov al, 0x40
+	call shadow_cmos_read
+	test al, 0x80
+	jz .done
+
+	mov cx, SHADOW_SYSTEM
+	call shadow_copy
+	call shadow_protect
+.done:
+	pop dx
+	pop cx
+	pop ax
+	ret
+
+; shadow_rom
+; Shadows an option ROM before its init call, its blocks stay writable for
+; the init code until shadow_protect. Skipped without a shadowed system BIOS
+; In:
+;   ES - option ROM segment
+;   DS = 0x40
+shadow_rom:
+	test word [shadow_blocks], SHADOW_SYSTEM
+	jz .done
+	push ax
+	push cx
+	; ROM size in 512 byte units to 16 KB blocks
+	movzx ax, byte [es:2]
+	add ax, 31
+	shr ax, 5
+	mov cx, ax
+	mov ax, 1
+	shl ax, cl
+	dec ax
+	mov cx, es
+	sub cx, 0xC000
+	shr cx, 10
+	shl ax, cl
+	and ax, SHADOW_OPTION
+	mov cx, [shadow_blocks]
+	not cx
+	and ax, cx
+	jz .skip
+	mov cx, ax
+	call shadow_copy
+.skip:
+	pop cx
+	pop ax
+.done:
+	ret
+
+; shadow_protect
+; Write protects the shadowed blocks
+; In:
+;   DS = 0x40
+shadow_protect:
+	push ax
+	push dx
+	mov ax, [shadow_blocks]
+	xor dx, dx
+	call shadow_set
+	pop dx
+	pop ax
+	ret
+
+; shadow_copy
+; Copies blocks onto their shadow RAM and switches their reads to RAM, the
+; copy is checked against a dword sum of the ROM. Leaves the blocks writable
+; In:
+;   CX - blocks to copy, bit n - 0xC0000 + n * 16 KB
+;   DS = 0x40
+; Out:
+;   CF = 1 - copy differs, the blocks stay in ROM
+shadow_copy:
+	pushad
+	push ds
+	push es
+	mov ax, [shadow_blocks]
+	mov dx, cx
+	call shadow_set ; ROM reads, RAM writes
+
+	cld
+	xor ebx, ebx
+	mov bp, cx
+	mov dx, 0xC000
+.copy:
+	shr bp, 1
+	jnc .copy_next
+	mov ds, dx
+	mov es, dx
+	xor si, si
+	xor di, di
+	mov cx, 0x1000 ; 16 KB in dwords
+.copy_dword:
+	lodsd
+	add ebx, eax
+	stosd
+	loop .copy_dword
+.copy_next:
+	add dx, 0x400
+	test bp, bp
+	jnz .copy
+
+	mov ax, 0x40
+	mov ds, ax
+	mov bp, sp
+	mov dx, [bp + 4 + 24] ; CX saved by pushad
+	mov ax, [shadow_blocks]
+	or ax, dx
+	call shadow_set ; RAM reads
+	wbinvd ; drop lines cached from the ROM
+
+	mov bp, dx
+	mov dx, 0xC000
+.check:
+	shr bp, 1
+	jnc .check_next
+	mov ds, dx
+	xor si, si
+	mov cx, 0x1000
+.check_dword:
+	lodsd
+	sub ebx, eax
+	loop .check_dword
+.check_next:
+	add dx, 0x400
+	test bp, bp
+	jnz .check
+
+	mov ax, 0x40
+	mov ds, ax
+	mov bp, sp
+	mov cx, [bp + 4 + 24]
+	test ebx, ebx
+	jnz .differs
+	or [shadow_blocks], cx
+	pop es
+	pop ds
+	popad
+	clc
+	ret
+.differs:
+	mov ax, [shadow_blocks]
+	xor dx, dx
+	call shadow_set
+	pop es
+	pop ds
+	popad
+	stc
+	ret
+
+; shadow_set
+; In:
+;   AX - blocks read from RAM
+;   DX - blocks written to RAM
+shadow_set:
+	push ax
+	push bx
+	pushf
+	cli
+	mov bx, ax
+	mov al, 0xF0
+	out 0x70, al
+	mov al, bl
+	out 0x71, al
+	mov al, 0xF1
+	out 0x70, al
+	mov al, bh
+	out 0x71, al
+	mov al, 0xF2
+	out 0x70, al
+	mov al, dl
+	out 0x71, al
+	mov al, 0xF3
+	out 0x70, al
+	mov al, dh
+	out 0x71, al
+	popf
+	pop bx
+	pop ax
+	ret
+
+; shadow_cmos_read
+; In:
+;   AL - CMOS register
+; Out:
+;   AL - value
+shadow_cmos_read:
+	out 0x70, al
+	jmp $+2
+	in al, 0x71
+	ret
@@ -0,0 +1,203 @@
+;
+; POST timeline
+;
+; Every POST code also records a timestamp: PIT input clocks (1193180 Hz)
+; since timeline_start, from the latched channel 0 count and the tick count.
+; Up to the C POST interrupts stay off (option ROMs start with IF clear, as
+; they always did) and the tick count stands still. A counter reload then
+; shows as IRQ0 waiting in the PIC, which only tells that one or more
+; periods (55 ms) passed. Such a checkpoint gets one period added and
+; TIMELINE_IMPRECISE in its flags byte, the time is a lower bound.
+; The table lives at TIMELINE_EARLY until the C POST moves it into the EBDA
+; (c_src/timeline.c), where it stays for DOS tools. Layout in data/ebda.asm
+;
+
+; timeline_start
+; Starts the timer in mode 2 and sets up the early table
+; Leaves IF and the PIC mask alone
+timeline_start:
+	push ax
+	push cx
+	push di
+	push es
+
+	mov al, 0x34 ; channel 0, mode 2, 65536 clocks per tick
+	out 0x43, al
+	xor al, al
+	out 0x40, al
+	out 0x40, al
+
+	mov ax, TIMELINE_EARLY >> 4
+	mov es, ax
+	xor di, di
+	mov cx, timeline_size
+	xor al, al
+	rep stosb
+	mov word [es:timeline.signature], TIMELINE_SIGNATURE
+	mov byte [es:timeline.max], TIMELINE_ENTRIES
+	mov dword [es:timeline.period], 0x10000
+	call timeline_irq0_clear
+
+	pop es
+	pop di
+	pop cx
+	pop ax
+	ret
+
+; timeline_table
+; Out:
+;   ES:DI - timeline, in the EBDA once the C POST has placed it
+timeline_table:
+	push ax
+	mov ax, 0x40
+	mov es, ax
+	mov ax, [es:ebda_segment]
+	mov di, ebda.timeline
+	test ax, ax
+	jnz .found
+	mov ax, TIMELINE_EARLY >> 4
+	xor di, di
+.found:
+	mov es, ax
+	pop ax
+	ret
+
+; timeline_now
+; In:
+;   ES:DI - timeline
+; Out:
+;   EAX - PIT clocks since timeline_start
+;   CF = 1 - reloads without a tick, whole periods may be missing
+; Destroys EBX, ECX, EDX
+timeline_now:
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+.retry:
+	call timeline_irq0_pending
+	mov dl, ah
+	mov bx, [ticks_low]
+	mov al, 0x00 ; latch channel 0
+	out 0x43, al
+	in al, 0x40
+	mov cl, al
+	in al, 0x40
+	mov ch, al
+	cmp bx, [ticks_low] ; a tick between the reads would mismatch the count
+	jne .retry
+	call timeline_irq0_pending ; so would a reload with interrupts off
+	cmp dl, ah
+	jne .retry
+	pop ds
+	push dx
+
+	; mode 2 counts from period down to 1, 0 reads as 65536
+	movzx ecx, cx
+	mov edx, [es:di + timeline.period]
+	sub edx, ecx
+	and edx, 0xFFFF
+	sub bx, [es:di + timeline.ticks]
+	movzx eax, bx
+	imul eax, [es:di + timeline.period]
+	add eax, edx
+	add eax, [es:di + timeline.base]
+
+	pop dx
+	test dl, dl
+	jz .done
+	; at least one reload since the last checkpoint, maybe more
+	call timeline_irq0_clear
+	mov edx, [es:di + timeline.period]
+	add [es:di + timeline.base], edx
+	add eax, edx
+	stc
+	ret
+.done:
+	clc
+	ret
+
+; timeline_irq0_pending
+; Out:
+;   AH = 1 - interrupts are off and IRQ0 waits in the PIC (counter reloaded)
+; Destroys AL
+timeline_irq0_pending:
+	pushf
+	pop ax
+	test ah, 0x02 ; IF, the timer interrupt counts the reloads itself
+	mov ah, 0
+	jnz .done
+	mov al, 0x0A ; OCW3: read IRR
+	out 0x20, al
+	in al, 0x20
+	and al, 0x01
+	mov ah, al
+.done:
+	ret
+
+; timeline_irq0_clear
+; Takes a waiting IRQ0 off the PIC while interrupts are off, so the next
+; checkpoint only sees new reloads
+timeline_irq0_clear:
+	push ax
+	call timeline_irq0_pending
+	test ah, ah
+	jz .done
+	mov al, 0x0C ; OCW3: poll, acknowledges IRQ0 (highest priority)
+	out 0x20, al
+	in al, 0x20
+	mov al, 0x60 ; specific EOI, IRQ0
+	out 0x20, al
+.done:
+	pop ax
+	ret
+
+; timeline_rebase
+; Called after the timer is set back to 65536 clocks per tick following
+; the C POST, which left the time of its exit in timeline.base
+timeline_rebase:
+	push eax
+	push di
+	push es
+	call timeline_table
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+	movzx eax, word [ticks_low]
+	pop ds
+	mov [es:di + timeline.ticks], eax
+	mov dword [es:di + timeline.period], 0x10000
+	call timeline_irq0_clear ; left over from the C POST timer
+	pop es
+	pop di
+	pop eax
+	ret
+
+; post_mark
+; Outputs a POST code to port 0x80 and records its timestamp
+; In:
+;   AL - POST code
+post_mark:
+	out 0x80, al
+	push es
+	pushad
+	mov bl, al
+	call timeline_table
+	cmp word [es:di + timeline.signature], TIMELINE_SIGNATURE
+	jne .done
+	mov al, [es:di + timeline.count]
+	cmp al, [es:di + timeline.max]
+	jae .done
+	movzx si, al
+	imul si, si, 6
+	mov [es:di + si + timeline.entries], bl
+	mov byte [es:di + si + timeline.entries + 1], 0
+	call timeline_now
+	jnc .precise
+	mov byte [es:di + si + timeline.entries + 1], TIMELINE_IMPRECISE
+.precise:
+	mov [es:di + si + timeline.entries + 2], eax
+	inc byte [es:di + timeline.count]
+.done:
+	popad
+	pop es
+	ret
@@ -0,0 +1,98 @@
+;
+; Microsecond clock
+;
+; Monotonic time since the boot for DOS software, from the uptime tick count
+; (never reset at midnight, unlike ticks_low/ticks_high) and the latched PIT
+; channel 0 count. Runs off the 18.2 Hz timer the BIOS leaves in mode 2
+; Served by INT 1Ah AH=F0h (isr/int1a_ext.asm) or a far call to usclock_far
+;
+
+; int08_uptime
+; IRQ0 vector, counts uptime_ticks and the INT 15h AH=83h wait interval,
+; writes the cursor INT 10h AH=0Eh left behind, then goes on to int08
+int08_uptime:
+	push ax
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+	inc dword [uptime_ticks]
+	call tty_cursor_flush
+
+	test byte [wait_active], 0x01
+	jz .done
+	sub dword [wait_count], 54925 ; us per tick
+	ja .done
+	push bx
+	push ds
+	lds bx, [wait_flag_ptr]
+	or byte [bx], 0x80
+	pop ds
+	pop bx
+	mov byte [wait_active], 0x80
+.done:
+	pop ds
+	pop ax
+	jmp int08
+
+; usclock_read
+; Out:
+;   EDX:EAX - microseconds since the boot, 48 bits used
+usclock_read:
+	push ebx
+	push ecx
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+
+	; tick count, PIT count and the pending IRQ0 as one sample
+	pushf
+	cli
+	mov al, 0x00 ; latch channel 0
+	out 0x43, al
+	in al, 0x40
+	mov cl, al
+	in al, 0x40
+	mov ch, al
+	mov ebx, [uptime_ticks]
+	mov al, 0x0A ; OCW3, read IRR
+	out 0x20, al
+	in al, 0x20
+	popf
+
+	; A tick the IRQ0 handler has not counted yet: the count was reloaded
+	; before the latch if it is still in the first half of the period
+	test al, 0x01
+	jz .counted
+	mov ax, cx
+	dec ax ; 0 reads as 65536
+	cmp ax, 0x7FFF
+	jb .counted
+	inc ebx
+.counted:
+
+	; mode 2 counts from 65536 down to 1
+	neg cx
+	movzx ecx, cx
+	imul ecx, ecx, 54925 ; us per 65536 PIT clocks (54925.4)
+	shr ecx, 16
+	mov eax, 27559 ; the 0.4205 us per tick left, x 65536
+	mul ebx
+	shrd eax, edx, 16
+	add ecx, eax
+	mov eax, 54925
+	mul ebx
+	add eax, ecx
+	adc edx, 0
+
+	pop ds
+	pop ecx
+	pop ebx
+	ret
+
+; usclock_far
+; Far call entry point, returned by INT 1Ah AX=F001h
+; Out:
+;   EDX:EAX - microseconds since the boot, 48 bits used
+usclock_far:
+	call usclock_read
+	retf
@@ -0,0 +1,125 @@
+;
+; Warm boot detection
+;
+; Ctrl-Alt-Del and software resets set 0x40:0x72 = 0x1234 (or CMOS shutdown
+; code 4) before jumping to the reset vector. Such a restart skips the
+; memory tests and the POST screen and reuses the memory size measured by
+; the last full POST.
+;
+; A CPU reset through port 92h or keyboard controller command FEh keeps the
+; CMOS shutdown byte (chipset version 0003), so 286 style protected mode
+; software can set code 05h or 0Ah and get back to real mode at 0040:0067.
+;
+
+; warm_boot_check
+; Jumped to from the reset entry, no stack yet
+; In:
+;   DS = 0x40
+; Out (jumps to normal_restart or pmode_exit):
+;   BP = 0 - cold boot
+;   BP = memory size in KB from the last full POST - warm boot
+warm_boot_check:
+	xor bp, bp
+	mov al, 0x0F
+	out 0x70, al
+	jmp $+2
+	in al, 0x71
+	cmp al, 0x05
+	je pmode_exit
+	cmp al, 0x0A
+	je pmode_exit
+
+	cmp word [warm_boot], 0x1234
+	je .check_size
+
+	; CMOS shutdown code 4 - boot without POST
+	cmp al, 0x04
+	jne normal_restart
+	mov al, 0x0F
+	out 0x70, al
+	jmp $+2
+	mov al, 0x00
+	out 0x71, al
+
+.check_size:
+	; BDA must have been set up by a full POST
+	cmp word [mem_total_kb], 0
+	je normal_restart
+
+	; Full POST on warm boot, settings snapshot of the last POST
+	test byte [bios_settings], 0x04
+	jnz normal_restart
+
+	mov bp, [mem_total_kb]
+	jmp normal_restart
+
+; pmode_exit
+; Resumes the program at pmode_exit_cs:pmode_exit_ip, SS:SP is up to it
+; In:
+;   AL - shutdown code 05h (EOI and keyboard flush first) or 0Ah
+;   DS = 0x40
+pmode_exit:
+	mov ah, al
+	; One-shot, a later reset must not resume again
+	mov al, 0x0F
+	out 0x70, al
+	jmp $+2
+	mov al, 0x00
+	out 0x71, al
+
+	; The reset unlocked the CMOS, lock it again as the POST did
+	test byte [bios_settings], 0x08
+	jz .unlocked
+	mov al, 0xFF
+	out 0x70, al
+	jmp $+2
+	mov al, 0x17
+	out 0x71, al
+.unlocked:
+
+	; It also cleared the shadow RAM enables, read the shadowed blocks from
+	; RAM again, write protected (shadow_set without a stack)
+	cmp word [shadow_blocks], 0
+	je .unshadowed
+	mov al, 0xF0
+	out 0x70, al
+	mov al, [shadow_blocks]
+	out 0x71, al
+	mov al, 0xF1
+	out 0x70, al
+	mov al, [shadow_blocks + 1]
+	out 0x71, al
+	mov al, 0xF2
+	out 0x70, al
+	xor al, al
+	out 0x71, al
+	mov al, 0xF3
+	out 0x70, al
+	xor al, al
+	out 0x71, al
+.unshadowed:
+	cmp ah, 0x0A
+	je .resume
+	in al, 0x60
+	mov al, 0x20
+	out 0x20, al
+.resume:
+	jmp far [pmode_exit_ip]
+
+; warm_boot_restore
+; Puts the warm boot state back into the freshly copied BDA
+; In:
+;   BP - value from warm_boot_check
+warm_boot_restore:
+	test bp, bp
+	jz .done
+	push ds
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	mov [mem_total_kb], bp
+	or byte [post_flags], 1
+	pop ax
+	pop ds
+.done:
+	ret
@@ -0,0 +1,100 @@
+; Extended memory access
+;
+; Real mode can't address the RAM above 1 MB, so copies are done in a short
+; 16-bit protected mode excursion with flat data segments
+;
+
+xmem_gdt:
+	dq 0
+	; 0x08: Code 16-bit (Base=0xF0000, Limit=64KB)
+	db 0xFF, 0xFF, 0x00, 0x00, 0x0F, 0x9A, 0x00, 0
+	; 0x10: Data 16-bit (Base=0, Limit=4GB)
+	db 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x92, 0x8F, 0
+	; 0x18: Data 16-bit (Base=0, Limit=64KB), real mode limits for the way back
+	db 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x92, 0x00, 0
+xmem_gdt_descriptor:
+	dw xmem_gdt_descriptor - xmem_gdt - 1
+	dd xmem_gdt + 0xF0000
+
+; xmem_copy
+; Copies memory between two linear addresses with 32-bit moves
+; Interrupts are disabled during the copy
+; In:
+;   ESI - source linear address
+;   EDI - destination linear address
+;   ECX - number of dwords
+; Out:
+;   CF = 0 - ok
+;   CF = 1 - not copied, the CPU is in virtual 8086 mode
+xmem_copy:
+	push ecx
+	shl ecx, 1
+	call xmem_copy_words
+	pop ecx
+	ret
+
+; xmem_copy_words
+; Same as xmem_copy, for INT 15h AH=87h
+; In:
+;   ECX - number of 16-bit words, an odd one is moved last
+xmem_copy_words:
+	push eax
+	smsw ax
+	test al, 1
+	jnz xmem_copy_v86
+
+	pushf
+	push ds
+	push es
+	push bp
+	push esi
+	push edi
+	push ecx
+	sub sp, 6
+	mov bp, sp
+
+	cli
+	o32 sgdt [bp] ; keep the caller's GDTR (DOS extenders)
+	o32 lgdt [cs:xmem_gdt_descriptor]
+	mov eax, cr0
+	or al, 1
+	mov cr0, eax
+	jmp 0x08:xmem_copy_pm
+
+xmem_copy_pm:
+	mov ax, 0x10
+	mov ds, ax
+	mov es, ax
+	cld
+	shr ecx, 1
+	a32 rep movsd
+	jnc xmem_copy_even
+	a32 movsw
+xmem_copy_even:
+
+	mov ax, 0x18
+	mov ds, ax
+	mov es, ax
+	mov eax, cr0
+	and al, ~1
+	mov cr0, eax
+	jmp 0xF000:xmem_copy_rm
+
+xmem_copy_rm:
+	o32 lgdt [bp]
+	add sp, 6
+	pop ecx
+	pop edi
+	pop esi
+	pop bp
+	pop es
+	pop ds
+	popf
+	pop eax
+	clc
+	ret
+
+xmem_copy_v86:
+	pop eax
+	stc
+	ret
@@ -0,0 +1,261 @@
+;
+; Fast text mode TTY
+;
+; INT 10h AH=0Eh and AH=13h in text modes. The video memory offset of the
+; cursor is kept in the BDA between calls, so consecutive characters only add
+; to it. AH=0Eh leaves the CRTC cursor to the next timer tick, AH=13h and any
+; other INT 10h call write it once. Everything else goes on to int10
+;
+
+; int10_tty
+; INT 10h vector
+int10_tty:
+	push ds
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	pop ax
+	cmp byte [video_mode], 3
+	ja .chain
+	cmp ah, 0x0E
+	je tty_putch
+	cmp ah, 0x13
+	je tty_string
+.chain:
+	mov word [tty_cursor], 0xFFFF ; the mode or cursor may change
+	call tty_cursor_flush
+	pop ds
+	jmp int10
+
+; AH=0Eh - teletype output
+;   AL - character
+tty_putch:
+	push bx
+	push dx
+	push di
+	push es
+	call tty_locate
+	xor bl, bl ; keep the attribute
+	call tty_char
+	call tty_store
+	pop es
+	pop di
+	pop dx
+	pop bx
+	pop ds
+	iret
+
+; AH=13h - write string
+;   AL - bit 0: move the cursor, bit 1: string has attribute bytes
+;   BL - attribute (AL bit 1 = 0)
+;   CX - characters
+;   DH, DL - row, column
+;   ES:BP - string
+tty_string:
+	push ax
+	push bx
+	push cx
+	push dx
+	push di
+	push bp
+	push es
+	push fs
+	push es
+	pop fs ; FS:BP - string
+
+	push word [cursor_pos]
+	mov [cursor_pos], dx
+	call tty_locate
+	mov bh, al ; mode
+	mov ah, bl
+	mov bl, 1 ; write the attribute
+	jcxz .end
+.next:
+	mov al, [fs:bp]
+	inc bp
+	test bh, 0x02
+	jz .char
+	mov ah, [fs:bp]
+	inc bp
+.char:
+	call tty_char
+	loop .next
+.end:
+	call tty_store
+	pop ax
+	test bh, 0x01
+	jnz .flush
+	mov [cursor_pos], ax
+.flush:
+	call tty_cursor_flush
+
+	pop fs
+	pop es
+	pop bp
+	pop di
+	pop dx
+	pop cx
+	pop bx
+	pop ax
+	pop ds
+	iret
+
+; tty_locate
+; In:
+;   DS = 0x40
+; Out:
+;   DX - cursor_pos
+;   ES:DI - its cell in the video memory
+tty_locate:
+	mov dx, 0xB800
+	mov es, dx
+	mov dx, [cursor_pos]
+	cmp dx, [tty_cursor]
+	jne .calc
+	mov di, [tty_offset]
+	ret
+.calc:
+	push ax
+	mov al, dh
+	mul byte [chars_per_line]
+	movzx di, dl
+	add di, ax
+	shl di, 1
+	pop ax
+	ret
+
+; tty_store
+; Saves the cursor from tty_char, the CRTC follows on the next flush
+; In:
+;   DX, DI - from tty_char
+;   DS = 0x40
+tty_store:
+	mov [cursor_pos], dx
+	mov [tty_cursor], dx
+	mov [tty_offset], di
+	or byte [tty_flags], 0x01
+	ret
+
+; tty_char
+; Writes a character at the cursor and moves it, CR, LF and BS only move it
+; In:
+;   AL - character, AH - attribute
+;   BL - 0: keep the attribute in the video memory
+;   DX - cursor, ES:DI - its cell
+;   DS = 0x40
+; Out:
+;   DX, DI - new cursor and cell, the screen scrolled up at the bottom
+tty_char:
+	cmp al, 13
+	je .cr
+	cmp al, 10
+	je .lf
+	cmp al, 8
+	je .bs
+	test bl, bl
+	jz .char_only
+	mov [es:di], ax
+	jmp .right
+.char_only:
+	mov [es:di], al
+.right:
+	add di, 2
+	inc dl
+	cmp dl, [chars_per_line]
+	jb .done
+	call .cr ; wrap to the next line
+	jmp .lf
+.cr:
+	push ax
+	movzx ax, dl
+	shl ax, 1
+	sub di, ax
+	pop ax
+	xor dl, dl
+	ret
+.lf:
+	cmp dh, [video_rows]
+	jae tty_scroll
+	inc dh
+	push ax
+	mov ax, [chars_per_line]
+	shl ax, 1
+	add di, ax
+	pop ax
+	ret
+.bs:
+	test dl, dl
+	jz .done
+	dec dl
+	sub di, 2
+.done:
+	ret
+
+; tty_scroll
+; Scrolls the whole screen up by one line, 32 bits at a time
+; In:
+;   ES = 0xB800
+;   DS = 0x40
+tty_scroll:
+	push eax
+	push cx
+	push si
+	push di
+	movzx si, byte [chars_per_line]
+	movzx cx, byte [video_rows]
+	imul cx, si ; cells to move
+	shr cx, 1
+	shl si, 1
+	xor di, di
+	cld
+	push ds
+	push es
+	pop ds
+	rep movsd
+	pop ds
+	movzx cx, byte [chars_per_line]
+	shr cx, 1
+	mov eax, 0x07000700
+	rep stosd
+	pop di
+	pop si
+	pop cx
+	pop eax
+	ret
+
+; tty_cursor_flush
+; Writes cursor_pos to the CRTC if the TTY moved it since the last write.
+; Also called by the timer, so the CRTC index a program left is restored
+; In:
+;   DS = 0x40
+tty_cursor_flush:
+	test byte [tty_flags], 0x01
+	jnz .write
+	ret
+.write:
+	pushf
+	cli
+	push ax
+	push bx
+	push dx
+	and byte [tty_flags], 0xFE
+	mov al, [cursor_pos + 1]
+	mul byte [chars_per_line]
+	movzx bx, byte [cursor_pos]
+	add bx, ax
+	mov dx, 0x3D4
+	in al, dx
+	push ax
+	mov al, 0x0E ; cursor location high
+	mov ah, bh
+	out dx, ax
+	mov al, 0x0F ; cursor location low
+	mov ah, bl
+	out dx, ax
+	pop ax
+	out dx, al
+	pop dx
+	pop bx
+	pop ax
+	popf
+	ret
@@ -83,113 +83,8 @@ putcha_graphic:
 
 	;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 putch_tty:
-
-
-	cmp byte [video_mode], 3
-	jg putch_tty_graphic
-
-	cmp al, 13
-	je cr
-	cmp al, 10
-	je lf
-	cmp al, 8
-	je backspace
-
-	push ax
-	push dx
-	push di
-
-	push ax
-	mov al, [cursor_pos + 1]
-	mov ah, [chars_per_line]
-	mul ah
-	mov dl, [cursor_pos]
-	xor dh, dh
-	add ax, dx
-	shl ax, 1
-	mov di, ax
-	pop ax
-	mov [es:di], al
-
-	pop di
-	pop dx
-	pop ax
-
-	inc byte [cursor_pos]
-	push ax
-	mov ah, [chars_per_line]
-	cmp byte [cursor_pos], ah
-	pop ax
-	jl int10_done
-	mov byte [cursor_pos], 0
-	jmp lf
-
-putch_tty_graphic:
-	jmp int10_done
-
-cr:
-	mov byte [cursor_pos], 0
-	jmp int10_done
-
-lf:
-	inc byte [cursor_pos + 1]
-	cmp byte [cursor_pos + 1], 25
-	jge int10_need_scroll
-	jmp int10_done
-int10_need_scroll:
-	mov byte [cursor_pos + 1], 24
-scroll_up:
-	push ax
-	push cx
-	push di
-	push si
-	push ds
-	push es
-	mov ax, 0xB800
-	mov ds, ax
-	mov es, ax
-	mov si, 160
-	mov di, 0
-	mov cx, 2000 - 80
-	cld
-	rep movsw
-	mov ax, 0x700
-	mov cx, 80
-	rep stosw
-	pop es
-	pop ds
-	pop si
-	pop di
-	pop cx
-	pop ax
-	jmp int10_done
-
-backspace:
-	mov al, byte [cursor_pos]
-	cmp al, 0
-	je int10_done
-
-	dec byte [cursor_pos]
-
-	push ax
-	push dx
-	push di
-
-	mov al, [cursor_pos + 1]
-	mov ah, [chars_per_line]
-	mul ah
-	mov dl, [cursor_pos]
-	xor dh, dh
-	add ax, dx
-	shl ax, 1
-	mov di, ax
-	mov al, ' '
-	; Should we?
-	; mov [es:di], al
-	pop di
-	pop dx
-	pop ax
-	
+	; Text modes are served by int10_tty (isr/int10_tty.asm)
+	; Graphic modes require too much space so not implemented
 	jmp int10_done
 
 ; int10_scroll_up
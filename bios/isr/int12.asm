@@ -1,4 +1,8 @@
 int12:
-	mov ax, [cs:lowram_size]	; Lower RAM size
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+	mov ax, [lowram_size]	; Lower RAM size, less the EBDA
+	pop ds
 	iret
 
@@ -2,6 +2,7 @@
 ;
 
 %include "drivers/ide.asm"
+%include "drivers/diskcache.asm"
 
 
 int13:
@@ -29,7 +30,7 @@ int13:
 	cmp ah, 0x10
 	; je int13_10
 	cmp ah, 0x15
-	; je int13_get_type
+	je int13_get_type
 
 	; AH = 41h - Get Extended Drive Parameters
     cmp ah, 0x41
@@ -37,6 +38,21 @@ int13:
     ; AH = 42h - Extended Read Sectors From Drive (LBA)
     cmp ah, 0x42
     je int13_func42
+    ; AH = 43h - Extended Write Sectors To Drive (LBA)
+    cmp ah, 0x43
+    je int13_func43
+    ; AH = 44h - Extended Verify Sectors (LBA)
+    cmp ah, 0x44
+    je int13_func44
+    ; AH = 47h - Extended Seek (LBA)
+    cmp ah, 0x47
+    je int13_func47
+    ; AH = 48h - Extended Read Drive Parameters
+    cmp ah, 0x48
+    je int13_func48
+    ; AH = F0h - Disk cache statistics (vendor)
+    cmp ah, 0xF0
+    je int13_cache
 
 	jmp int13_no_command
 
@@ -76,6 +92,19 @@ int13_no_command:
 	stc
 	jmp iret_carry
 
+; int13_error
+; Returns the status in AH to the caller with CF set
+int13_error:
+	push ds
+	push bx
+	mov bx, 0x40
+	mov ds, bx
+	mov [disk_error], ah
+	pop bx
+	pop ds
+	stc
+	jmp iret_carry
+
 int13_no_drive:
 	push ax
 	push ds
@@ -126,16 +155,30 @@ int13_read:
 	mov al, 1
 int13_read_check_al_done:
 
+	; drives without LBA get the CHS address as is
+	call int13_lba_drive
+	jnc int13_read_direct
+	push si
+	mov si, IDE_OP_READ
+	call int13_chs_lba
+	pop si
+	jc int13_error
+	jmp int13_success
+
+int13_read_direct:
 	push ax
 	push bx
 	push cx
 	push dx
 	call ide_read
-	pop dx
+	pop dx ; pop keeps CF from ide_read
 	pop cx
 	pop bx
 	pop ax
-	jmp int13_success
+	jnc int13_success
+	call ide_error_code
+	xor al, al ; sectors transferred
+	jmp int13_error
 
 	jmp int13_not_ready
 
@@ -162,16 +205,30 @@ int13_write:
 	mov al, 1
 int13_write_check_al_done:
 
+	; drives without LBA get the CHS address as is
+	call int13_lba_drive
+	jnc int13_write_direct
+	push si
+	mov si, IDE_OP_WRITE
+	call int13_chs_lba
+	pop si
+	jc int13_error
+	jmp int13_success
+
+int13_write_direct:
 	push ax
 	push bx
 	push cx
 	push dx
 	call ide_write
-	pop dx
+	pop dx ; pop keeps CF from ide_write
 	pop cx
 	pop bx
 	pop ax
-	jmp int13_success
+	jnc int13_success
+	call ide_error_code
+	xor al, al ; sectors transferred
+	jmp int13_error
 
 	jmp int13_not_ready
 
@@ -193,13 +250,30 @@ int13_get_params:
 	je int13_08_floppy
 	cmp dl, 0x80
 	jne int13_no_drive
-	mov bl, 41
-	mov dl, 1
-	mov dh, 15
-	mov ch, 255	; cyl
-	mov cl, 255	; sect
+
+	push ds
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	call int13_cylinders
+	jz int13_08_none
+	dec ax		; last cylinder
+	mov ch, al
+	mov cl, ah
+	shl cl, 6
+	or cl, [ide_spt]
+	mov dh, [ide_heads]
+	dec dh		; last head
+	pop ax
+	pop ds
+	mov dl, 1	; number of drives
 	jmp int13_success
 
+int13_08_none:
+	pop ax
+	pop ds
+	jmp int13_no_drive
+
 int13_08_floppy:
 	mov ax, cs
 	mov es, ax
@@ -236,69 +310,325 @@ int13_get_type:
 	je int13_15_floppy
 	cmp dl, 0x80
 	jne int13_no_drive
-	mov ah, 3
-	mov cx, 0x000F ; 504 MB
-	mov dx, 0xC000
-	jmp int13_success
+
+	; CX:DX = cylinders * heads * sectors, as reported by AH=08h
+	push ds
+	push eax
+	mov ax, 0x40
+	mov ds, ax
+	call int13_cylinders
+	jz int13_15_none
+	movzx eax, ax
+	movzx edx, byte [ide_heads]
+	imul eax, edx
+	movzx edx, byte [ide_spt]
+	imul eax, edx
+	mov dx, ax
+	shr eax, 16
+	mov cx, ax
+	pop eax
+	pop ds
+	mov ah, 3	; fixed disk
+	clc
+	jmp iret_carry
+
+int13_15_none:
+	pop eax
+	pop ds
+	jmp int13_no_drive
 
 int13_15_floppy:
 	mov ah, 1
-	jmp int13_success
+	clc
+	jmp iret_carry
+
+; int13_cylinders
+; Returns the cylinder count reported to CHS callers (at most 1024)
+; In:
+;   DS - 0x40
+; Out:
+;   AX - number of cylinders, ZF = 1 if no drive was detected
+int13_cylinders:
+	mov ax, [ide_cylinders]
+	cmp ax, 1024
+	jbe int13_cylinders_done
+	mov ax, 1024
+int13_cylinders_done:
+	or ax, ax
+	ret
+
+; int13_lba_drive
+; Out:
+;   CF = 1 - the drive accepts LBA commands
+int13_lba_drive:
+	push ds
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	mov al, [ide_flags]
+	shr al, 1 ; CF = IDE_FLAG_LBA
+	pop ax
+	pop ds
+	ret
 
 
 int13_func41:
 	call ide_check_lba
-	jmp int13_success
+	jc int13_no_command
+	jmp iret_carry ; keep the EDD version in AH
 
+; int13_func42 / int13_func43 / int13_func44
+; Extended read / write / verify
+; In:
+;   AL - write flags (AH=43h only, verify after write is not done)
+;   DL - drive number
+;   DS:SI - disk address packet
+int13_func43:
+%if (DISKS_READONLY)
+	cmp dl, 0x80
+	jne int13_not_ready
+	jmp int13_success
+%endif
 int13_func42:
-	call ide_read_lba
+int13_func44:
+	cmp dl, 0x80
+	jne int13_not_ready
+	call int13_lba_drive
+	jnc int13_no_command ; CHS only drive
+	call int13_lba_packet
+	jc int13_error
 	jmp int13_success
 
-; int13_calc_lba
-; Convert CHS to LBA
+; int13_func47
+; Extended seek, only checks the packet LBA against the drive size. The
+; next transfer positions the heads itself
 ; In:
-;   AL - number of sectors to read
+;   DL - drive number
+;   DS:SI - disk address packet
+int13_func47:
+	cmp dl, 0x80
+	jne int13_not_ready
+	call int13_lba_drive
+	jnc int13_no_command ; CHS only drive
+	cmp byte [ds:si], 0x10
+	jb int13_47_invalid
+	push es
+	push eax
+	mov ax, 0x40
+	mov es, ax
+	mov eax, [ds:si + 12]
+	cmp eax, [es:ide_sectors + 4]
+	jb int13_47_ok
+	ja int13_47_range
+	mov eax, [ds:si + 8]
+	cmp eax, [es:ide_sectors]
+	jae int13_47_range
+int13_47_ok:
+	pop eax
+	pop es
+	jmp int13_success
+int13_47_range:
+	pop eax
+	pop es
+int13_47_invalid:
+	mov ah, 0x01 ; invalid parameter
+	jmp int13_error
+
+; int13_lba_packet
+; Extended read / write / verify (int 13h AH=42h-44h), reads go through the
+; disk cache
+; In:
+;   AH - 0x42 read, 0x43 write, 0x44 verify
+;   DS:SI - disk address packet:
+;     Offset Size Description
+;     0      1    Size of packet (10h or more)
+;     1      1    Reserved (must be 0)
+;     2      2    Number of blocks to transfer, set to blocks transferred
+;     4      2    Buffer offset
+;     6      2    Buffer segment
+;     8      8    Starting LBA (QWORD), bits 0-47 are used
+; Out:
+;   CF = 0 - ok, AH = 0
+;   CF = 1 - error, AH = int 13h status
+int13_lba_packet:
+	push es
+	push bx
+	push ecx
+	push edx
+	push di
+	push eax
+
+	mov cl, 0x01 ; invalid parameter
+	cmp byte [ds:si], 0x10
+	jb int13_lba_packet_error
+	; 64-bit flat buffer address (FFFF:FFFF) is not supported
+	cmp dword [ds:si + 4], 0xFFFFFFFF
+	je int13_lba_packet_error
+	; LBA above 48 bits
+	cmp word [ds:si + 14], 0
+	jne int13_lba_packet_error
+
+	push si
+	movzx di, ah
+	sub di, 0x42 ; operation
+	mov eax, [ds:si + 8]
+	mov dx, [ds:si + 12]
+	mov cx, [ds:si + 2]
+	les bx, [ds:si + 4]
+	mov si, di
+	call dcache_xfer
+	pop si
+	mov [ds:si + 2], cx ; blocks transferred
+	mov cl, ah
+	jmp int13_lba_packet_done
+
+int13_lba_packet_error:
+	stc
+int13_lba_packet_done:
+	pop eax
+	mov ah, cl
+	pop di
+	pop edx
+	pop ecx
+	pop bx
+	pop es
+	ret
+
+
+; int13_func48
+; Extended read drive parameters
+; In:
+;   DL - drive number
+;   DS:SI - result buffer
+int13_func48:
+	cmp dl, 0x80
+	jne int13_no_drive
+	call ide_drive_params
+	jc int13_error
+	jmp int13_success
+
+; int13_chs_lba
+; CHS read / write issued as LBA commands (through the disk cache), the
+; address is translated with int13_calc_lba
+; In:
+;   SI - IDE_OP_READ / IDE_OP_WRITE
+;   AL - number of sectors
 ;   CH - cylinder
 ;   CL - sector
 ;   DH - head
-;   DL - drive number
+;   ES:BX - buffer
+; Out:
+;   CF = 0 - ok
+;   CF = 1 - error, AH = int 13h status
+;   AL - number of sectors transferred
+int13_chs_lba:
+	push bp
+	mov bp, sp
+	push eax ; [bp-4]
+	push ecx
+	push edx
+
+	call int13_calc_lba
+	jc int13_chs_lba_invalid
+	movzx cx, byte [bp-4] ; number of sectors
+	xor dx, dx
+	call dcache_xfer
+int13_chs_lba_done:
+	mov [bp-4], cl
+	mov [bp-3], ah
+
+	pop edx
+	pop ecx
+	pop eax
+	pop bp
+	ret
+
+int13_chs_lba_invalid:
+	xor cx, cx
+	mov ah, 0x01 ; invalid parameter
+	stc
+	jmp int13_chs_lba_done
+
+; int13_cache
+; Disk cache statistics (vendor function)
+; In:
+;   AL - 0x00 get counters, 0x01 clear counters, 0x02 empty the cache
+; Out:
+;   CF = 0 - ok, for AL = 0x00:
+;     EBX - sectors served from the cache
+;     ECX - sectors read from the drive
+;     DX - cache size in sectors
+;   CF = 1 - cache disabled or bad subfunction, AH = 0x01
+int13_cache:
+	push fs
+	call dcache_check
+	jc int13_cache_invalid
+	cmp al, 0
+	je int13_cache_get
+	cmp al, 1
+	je int13_cache_clear
+	cmp al, 2
+	je int13_cache_flush
+int13_cache_invalid:
+	pop fs
+	jmp int13_no_command
+
+int13_cache_get:
+	mov ebx, [fs:ebda.dcache_hits]
+	mov ecx, [fs:ebda.dcache_misses]
+	mov dx, DCACHE_SETS * DCACHE_WAYS
+	jmp int13_cache_done
+int13_cache_clear:
+	mov dword [fs:ebda.dcache_hits], 0
+	mov dword [fs:ebda.dcache_misses], 0
+	jmp int13_cache_done
+int13_cache_flush:
+	call dcache_flush
+int13_cache_done:
+	pop fs
+	jmp int13_success
+
+; int13_calc_lba
+; Converts a CHS address to LBA with the geometry reported by AH=08h
+; lba = (cylinder * heads + head) * sectors + sector - 1
+; In:
+;   CH - cylinder bits 0-7
+;   CL - sector (bits 0-5), cylinder bits 8-9 (bits 6-7)
+;   DH - head
+; Out:
+;   CF = 0 - ok, EAX - LBA
+;   CF = 1 - sector 0
 int13_calc_lba:
-	; lba = (cyl * num_heads + head) * num_sects + sect - 1
-	; lba = (CH * 16 + DH) * 63 + CL
-	; temp = cx;
-	; CX = CH;
-	; CX <<= 4;
-	; DX = DH;
-	; CX += DX;
-	; AX = CX * 63;
-	; CX = temp;
-	; CH = 0;
-	; AX += CX;
-
-	push cx		; temp = CX;
-	xchg cl, ch	; CX = CH;
-
-	shr ch, 1
-	shr ch, 1
-	shr ch, 1
-	shr ch, 1
-	shr ch, 1
-	shr ch, 1
-
-	and cx, 0x3FF
-	shl cx, 1	; CX <<= 4;
-	shl cx, 1
-	shl cx, 1
-	shl cx, 1
-	mov dl, dh      ; DX = DH;
-	xor dh, dh
-	add cx, dx      ; CX += DX;
-	mov ax, 63	
-	mul cx          ; DX:AX = CX * 63;
-	pop cx
-	and cx, 0x3F
+	push ds
+	push ebx
+	push ecx
+	push edx
+
+	mov ax, 0x40
+	mov ds, ax
+
+	movzx ebx, dh
+	movzx eax, cl
+	shl ax, 2
+	mov al, ch
+	and ax, 0x3FF ; cylinder
+	movzx edx, byte [ide_heads]
+	imul eax, edx
+	add eax, ebx
+	movzx edx, byte [ide_spt]
+	imul eax, edx
+	and ecx, 0x3F
+	jz int13_calc_lba_invalid ; sectors start at 1
 	dec cx
-	add ax, cx	; AX += CL;
-	adc dx, 0       ; DX:AX = lba32
+	add eax, ecx
+	clc
+int13_calc_lba_done:
+	pop edx
+	pop ecx
+	pop ebx
+	pop ds
+	ret
 
-	ret
\ No newline at end of file
+int13_calc_lba_invalid:
+	stc
+	jmp int13_calc_lba_done
@@ -1,40 +1,314 @@
 	; Communication / RS232 functions
+	;
+	; AH = 00h-03h - standard, 04h - extended init (CL baud index up to
+	;                0Bh = 115200), see drivers/serial.asm for the buffering
+	; AH = F0h - read what is buffered, ES:BX - buffer, CX - max bytes
+	;            Out: CX - bytes read, AH - line errors since the last call
+	; AH = F1h - queue bytes, ES:BX - data, CX - bytes
+	;            Out: CX - bytes queued (less when the buffer is full), AH - line status
+	; AH = F2h - buffer status
+	;            Out: AX - bytes received, CX - free space to send
+	; F0h-F2h work on COM1/COM2 once set up, otherwise AH = 80h and CX = 0
+
+%include "drivers/serial.asm"
 
 int14:
-	cmp ah, 0
+	push bx
+	push dx
+	push si
+	push edi
+	push ds
+	push fs
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	pop ax
+	cld
+	mov di, dx ; port index, for the timeout
+	call serial_port
+	jc int14_no_port
+
+	cmp ah, 0x00
 	je int14_init
-;	cmp ah, 1
-;	je int14_write_char
-;	cmp ah, 2
-;	je int14_read_char
-;	cmp ah, 3
-;	je int14_get_status
+	cmp ah, 0x01
+	je int14_write
+	cmp ah, 0x02
+	je int14_read
+	cmp ah, 0x03
+	je int14_status
+	cmp ah, 0x04
+	je int14_init_ext
+	cmp ah, 0xF0
+	je int14_bulk_read
+	cmp ah, 0xF1
+	je int14_bulk_write
+	cmp ah, 0xF2
+	je int14_buffer_status
 
+int14_no_port:
+	mov ah, 0x80 ; timeout
+int14_done:
+	pop fs
+	pop ds
+	pop edi
+	pop si
+	pop dx
+	pop bx
 	iret
 
 int14_init:
-	push dx
-	mov al, 0x00
-	mov dx, 0x3F8
-	out dx, al
-	mov al, 0x00
-	mov dx, 0x3F9
-	out dx, al
-	mov dx, 0x3FA
-	out dx, al
-	mov dx, 0x3FE
-	out dx, al
-	mov dx, 0x3FF
-	out dx, al
-	mov al, 0xA3
-	mov dx, 0x3FB
-	out dx, al
-	mov al, 0x03
-	mov dx, 0x3FC
-	out dx, al
-	mov al, 0x00
-	mov dx, 0x3FD
+	push cx
+	movzx bx, al
+	shr bx, 5
+	shl bx, 1
+	mov cx, [cs:serial_divisors + bx]
+	and al, 0x1F ; word length, stop bits and parity map to the LCR
+	call serial_setup
+	pop cx
+	jmp int14_done
+
+int14_init_ext:
+	cmp cl, 0x0B
+	ja int14_no_port
+	cmp bh, 4
+	ja int14_no_port
+	push cx
+	shl al, 6 ; break
+	and al, 0x40
+	mov ah, ch
+	and ah, 0x03 ; word length
+	or al, ah
+	mov ah, bl
+	and ah, 0x01 ; stop bits
+	shl ah, 2
+	or al, ah
+	movzx bx, bh
+	or al, [cs:serial_parity + bx]
+	movzx bx, cl
+	shl bx, 1
+	mov cx, [cs:serial_divisors + bx]
+	call serial_setup
+	pop cx
+	jmp int14_done
+
+int14_status:
+	call serial_status
+	call serial_buffered
+	jz int14_done
+	or ah, [fs:si + serial.lsr]
+	mov byte [fs:si + serial.lsr], 0
+	and ah, 0x9E ; data ready and transmitter empty come from the buffers
+	mov bx, [fs:si + serial.tx_head]
+	cmp bx, [fs:si + serial.tx_tail]
+	jne .tx_busy
+	or ah, 0x60
+.tx_busy:
+	mov bx, [fs:si + serial.rx_head]
+	cmp bx, [fs:si + serial.rx_tail]
+	je int14_done
+	or ah, 0x01
+	jmp int14_done
+
+int14_write:
+	call serial_deadline
+	call serial_buffered
+	jz .polled
+.wait:
+	cli
+	mov bx, [fs:si + serial.tx_head]
+	inc bx
+	and bx, SERIAL_TX_SIZE - 1
+	cmp bx, [fs:si + serial.tx_tail]
+	jne .queue
+	call serial_expired
+	jc .timeout
+	sti
+	hlt ; the IRQ makes room
+	jmp .wait
+.queue:
+	xchg bx, [fs:si + serial.tx_head]
+	mov [fs:si + bx + serial.tx], al
+	call serial_tx_start
+	jmp .done
+
+.polled:
+	mov bl, al
+.poll:
+	add dx, 5
+	in al, dx ; LSR
+	sub dx, 5
+	test al, 0x20
+	jnz .send
+	call serial_expired
+	jnc .poll
+	mov al, bl
+	jmp .timeout
+.send:
+	mov al, bl
 	out dx, al
-	pop dx
-	iret
+.done:
+	mov bl, al
+	call serial_status
+	mov al, bl
+	and ah, 0x7F
+	jmp int14_done
+.timeout:
+	mov bl, al
+	call serial_status
+	mov al, bl
+	or ah, 0x80
+	jmp int14_done
+
+int14_read:
+	call serial_deadline
+	call serial_buffered
+	jz .polled
+.wait:
+	cli
+	mov bx, [fs:si + serial.rx_tail]
+	cmp bx, [fs:si + serial.rx_head]
+	jne .take
+	call serial_expired
+	jc .timeout
+	sti
+	hlt ; woken up by the IRQ or the timer
+	jmp .wait
+.take:
+	mov al, [fs:si + bx + serial.rx]
+	inc bx
+	and bx, SERIAL_RX_SIZE - 1
+	mov [fs:si + serial.rx_tail], bx
+	mov ah, [fs:si + serial.lsr]
+	mov byte [fs:si + serial.lsr], 0
+	and ah, 0x1E
+	jmp int14_done
+
+.polled:
+	add dx, 5
+	in al, dx ; LSR
+	sub dx, 5
+	test al, 0x01
+	jnz .get
+	call serial_expired
+	jnc .polled
+	jmp .timeout
+.get:
+	mov ah, al
+	and ah, 0x1E
+	in al, dx
+	jmp int14_done
+.timeout:
+	call serial_status
+	or ah, 0x80
+	jmp int14_done
+
+int14_bulk_read:
+	call serial_buffered
+	jz int14_bulk_none
+	mov di, bx ; ES:DI - buffer
+	mov dx, cx
+	xor cx, cx
+	mov bx, [fs:si + serial.rx_tail]
+.next:
+	cmp cx, dx
+	jae .done
+	cmp bx, [fs:si + serial.rx_head]
+	je .done
+	mov al, [fs:si + bx + serial.rx]
+	stosb
+	inc bx
+	and bx, SERIAL_RX_SIZE - 1
+	inc cx
+	jmp .next
+.done:
+	mov [fs:si + serial.rx_tail], bx
+	mov ah, [fs:si + serial.lsr]
+	mov byte [fs:si + serial.lsr], 0
+	and ah, 0x1E
+	jmp int14_done
+
+int14_bulk_write:
+	call serial_buffered
+	jz int14_bulk_none
+	mov di, bx ; ES:DI - data
+	mov dx, cx
+	xor cx, cx
+	mov bx, [fs:si + serial.tx_head]
+.next:
+	cmp cx, dx
+	jae .done
+	mov ax, bx
+	inc ax
+	and ax, SERIAL_TX_SIZE - 1
+	cmp ax, [fs:si + serial.tx_tail]
+	je .done ; full
+	push ax
+	mov al, [es:di]
+	mov [fs:si + bx + serial.tx], al
+	pop bx
+	inc di
+	inc cx
+	jmp .next
+.done:
+	mov [fs:si + serial.tx_head], bx
+	mov dx, [fs:si + serial.base]
+	jcxz .status
+	call serial_tx_start
+.status:
+	call serial_status
+	jmp int14_done
+
+int14_buffer_status:
+	call serial_buffered
+	jz int14_bulk_none
+	mov ax, [fs:si + serial.rx_head]
+	sub ax, [fs:si + serial.rx_tail]
+	and ax, SERIAL_RX_SIZE - 1
+	mov cx, [fs:si + serial.tx_tail]
+	sub cx, [fs:si + serial.tx_head]
+	dec cx
+	and cx, SERIAL_TX_SIZE - 1
+	jmp int14_done
+
+int14_bulk_none:
+	xor cx, cx
+	mov ax, 0x8000
+	jmp int14_done
+
+; serial_deadline
+; In:
+;   DI - port index
+;   DS = 0x40
+; Out:
+;   EDI - uptime_ticks value when the BDA timeout (seconds) runs out
+serial_deadline:
+	push eax
+	movzx eax, byte [com_timeouts + di]
+	imul eax, eax, 18
+	add eax, [uptime_ticks]
+	mov edi, eax
+	pop eax
+	ret
+
+; serial_expired
+; In:
+;   EDI - from serial_deadline
+; Out:
+;   CF = 1 - timed out
+serial_expired:
+	push eax
+	mov eax, [uptime_ticks]
+	sub eax, edi
+	pop eax
+	jns .expired
+	clc
+	ret
+.expired:
+	stc
+	ret
 
+serial_divisors: ; 115200 / baud
+	dw 1047, 768, 384, 192, 96, 48, 24, 12 ; 110 - 9600, AH=00h bits 7-5
+	dw 6, 3, 2, 1 ; 19200 - 115200, AH=04h only
+serial_parity: ; AH=04h BH: none, odd, even, stick odd, stick even
+	db 0x00, 0x08, 0x18, 0x28, 0x38
@@ -7,6 +7,12 @@
 int15:
 	cmp ah, 0x24
 	je int15_a20
+	cmp ah, 0x83
+	je int15_event_wait
+	cmp ah, 0x86
+	je int15_wait
+	cmp ah, 0x87
+	je int15_blockmove
 	cmp ah, 0x88
 	je int15_memsize
 	cmp ah, 0xC0
@@ -17,6 +23,10 @@ int15:
 	je int15_memsize2
 	cmp ah, 0x8A
 	je int15_memsize3
+	cmp ah, 0x90
+	je int15_device_hook
+	cmp ah, 0x91
+	je int15_device_hook
 
 	mov ah, 0x86
 	jmp iret_carry_on
@@ -72,13 +82,176 @@ int15_a20_get_support:
 	clc
 	jmp iret_carry
 
+; int15_event_wait
+; AH=83h, bit 7 of the flag byte is set when the interval has passed,
+; counted down by the timer interrupt (int08_uptime)
+; In:
+;   AL = 00h - start, CX:DX - microseconds, ES:BX - flag byte
+;   AL = 01h - cancel
+; Out:
+;   CF = 0 - ok
+;   CF = 1 - a wait is already in progress
+int15_event_wait:
+	push ds
+	push di
+	mov di, 0x40
+	mov ds, di
+	cmp al, 0x01
+	je .cancel
+	test byte [wait_active], 0x01
+	jnz .busy
+	mov [wait_flag_ptr], bx
+	mov [wait_flag_ptr + 2], es
+	mov [wait_count], dx
+	mov [wait_count + 2], cx
+	mov byte [wait_active], 0x01
+	jmp .done
+.cancel:
+	mov byte [wait_active], 0
+.done:
+	pop di
+	pop ds
+	clc
+	jmp iret_carry
+.busy:
+	pop di
+	pop ds
+	jmp iret_carry_on
+
+; int15_wait
+; AH=86h, waits with HLT between the timer ticks and polls the
+; microsecond clock (drivers/usclock.asm) through the last one
+; In:
+;   CX:DX - microseconds
+; Out:
+;   AH = 00h, CF = 0 - ok
+;   AH = 83h, CF = 1 - an AH=83h wait is in progress
+int15_wait:
+	push ds
+	push ax
+	mov ax, 0x40
+	mov ds, ax
+	test byte [wait_active], 0x01
+	pop ax
+	pop ds
+	jnz .busy
+
+	sti
+	push eax
+	push ebx
+	push ecx
+	push edx
+	push esi
+	push edi
+
+	shl ecx, 16
+	mov cx, dx
+	call usclock_read
+	mov esi, eax ; EDI:ESI - end of the wait
+	mov edi, edx
+	add esi, ecx
+	adc edi, 0
+
+.next:
+	call usclock_read
+	mov ebx, esi
+	mov ecx, edi
+	sub ebx, eax
+	sbb ecx, edx
+	jb .done
+	jnz .halt
+	cmp ebx, 54925 ; less than a tick left
+	jb .next
+.halt:
+	hlt
+	jmp .next
+
+.done:
+	pop edi
+	pop esi
+	pop edx
+	pop ecx
+	pop ebx
+	pop eax
+	xor ah, ah
+	jmp iret_carry
+.busy:
+	mov ah, 0x83
+	jmp iret_carry_on
+
+; int15_device_hook
+; AH=90h device busy / AH=91h interrupt complete
+; Called by the keyboard wait (isr/int16_idle.asm) and IRQ1, so multitasking
+; loaders hooking INT 15h can switch tasks. Nothing to do here
+int15_device_hook:
+	xor ah, ah
+	jmp iret_carry
+
+; int15_blockmove
+; Extended memory block move, done by xmem_copy_words
+; In:
+;   CX - number of words, up to 8000h (64 KB)
+;   ES:SI - caller's GDT, source descriptor at +10h, destination at +18h
+; Out:
+;   AH = 00h, CF = 0 - copied
+;   AH = 02h, CF = 1 - not copied, the CPU is in virtual 8086 mode
+;   AH = 80h, CF = 1 - more than 64 KB
+int15_blockmove:
+	cmp cx, 0x8000
+	ja .too_long
+	push eax
+	push bx
+	push ecx
+	push esi
+	push edi
+
+	lea bx, [si + 0x18]
+	call int15_descriptor_base
+	mov edi, eax
+	lea bx, [si + 0x10]
+	call int15_descriptor_base
+	mov esi, eax
+	movzx ecx, cx
+	call xmem_copy_words
+
+	pop edi
+	pop esi
+	pop ecx
+	pop bx
+	pop eax
+	mov ah, 0x02
+	jc .fail
+	xor ah, ah
+	jmp iret_carry
+
+.too_long:
+	mov ah, 0x80
+.fail:
+	jmp iret_carry_on
+
+; int15_descriptor_base
+; In:
+;   ES:BX - segment descriptor
+; Out:
+;   EAX - 32-bit base
+int15_descriptor_base:
+	mov al, [es:bx + 4] ; base 16-23
+	mov ah, [es:bx + 7] ; base 24-31, 0 in 286 style tables
+	shl eax, 16
+	mov ax, [es:bx + 2] ; base 0-15
+	ret
+
 int15_memsize:
-	mov ax, EXT_RAM_SIZE
+	call int15_ext_kb
 	clc
 	jmp iret_carry
 
 int15_memsize2:
-	mov ax, EXT_RAM_SIZE
+	call int15_ext_kb
+	cmp ax, 15 * 1024 ; 1 MB - 16 MB only
+	jbe .below_16m
+	mov ax, 15 * 1024
+.below_16m:
 	mov cx, ax
 	xor bx, bx
 	mov dx, bx
@@ -86,7 +259,7 @@ int15_memsize2:
 	jmp iret_carry
 
 int15_memsize3:
-	mov ax, EXT_RAM_SIZE
+	call int15_ext_kb
 	xor dx, dx
 	clc
 	jmp iret_carry
@@ -99,100 +272,119 @@ int15_getconfig:
 	clc
 	jmp iret_carry
 	
-int15_memmap:
-	mov eax, 0x534D4150 ; signature
-	; ES:DI	Buffer Pointer
-
-	cmp ebx, 0
-	je .copy_0
-
-	cmp ebx, 1
-	je .copy_1
-
-	cmp ebx, 2
-	je .copy_2
+%define INT15_MEMMAP_STATIC	3 ; entries in int15_memmap_static
 
-	cmp ebx, 3
-	je .copy_3
-
-	cmp ebx, 4
-	je .copy_4
-
-	jmp iret_carry_on
+int15_memmap:
+	; ES:DI	Buffer Pointer, EBX - entry index
+	push fs
+	call int15_memmap_ebda
+	jc .static
+	movzx ecx, byte [fs:ebda.memmap_count]
+	cmp ebx, ecx
+	jae .fail
 
-.copy_0:
-	mov ecx, int15_memmap_0
-	mov ebx, 1
-	jmp .copy
-.copy_1:
-	mov ecx, int15_memmap_1
-	mov ebx, 2
-	jmp .copy
-.copy_2:
-	mov ecx, int15_memmap_2
-	mov ebx, 3
-	jmp .copy
-.copy_3:
-	mov ecx, int15_memmap_3
-	mov ebx, 4
-	jmp .copy
-.copy_4:
-	mov ecx, int15_memmap_4
-	mov ebx, 0
-	jmp .copy
-
-.copy:
 	push si
-	push ds
 	push di
-
-	push cs ; DS = CS
+	push ds
+	imul si, bx, MEMMAP_ENTRY_SIZE
+	add si, ebda.memmap
+	push fs ; DS = EBDA
 	pop ds
-	mov si, cx
-
-	mov ecx, 20
-    cld
-    rep movsb           ; DS:SI -> ES:DI
-
-	pop di
+	mov cx, MEMMAP_ENTRY_SIZE / 2
+	cld
+	rep movsw ; DS:SI -> ES:DI
 	pop ds
+	pop di
 	pop si
 
-	mov ecx, 20
-
-	cmp ebx, 0
-	je .finished
-
+	inc ebx
+	cmp bl, [fs:ebda.memmap_count]
+	jb .more
+	xor ebx, ebx ; last entry
+.more:
+	pop fs
+	mov eax, 0x534D4150 ; signature
+	mov ecx, MEMMAP_ENTRY_SIZE
+	clc
 	jmp iret_carry
 
-.finished:
-	xor ebx, ebx
+.fail:
+	pop fs
+	mov ah, 0x86
 	jmp iret_carry_on
 
+	; before the C POST (option ROMs): conventional and extended RAM only
+.static:
+	cmp ebx, INT15_MEMMAP_STATIC
+	jae .fail
+	push si
+	push di
+	push ds
+	imul si, bx, MEMMAP_ENTRY_SIZE
+	add si, int15_memmap_static
+	push cs
+	pop ds
+	mov cx, MEMMAP_ENTRY_SIZE / 2
+	cld
+	rep movsw ; DS:SI -> ES:DI
+	pop ds
+	pop di
+	pop si
 
-int15_memmap_0: ; 0x0000000 - 0x009FFFF: available
-	dq 0x00000000 
-	dq 0x000A0000
-	dd 1
-; 0xA0000 - 0xC8000 ISA space
-int15_memmap_1: ; 0x00C8000 - 0x0100000: reserved
-	dq 0x0000C8000
-	dq 0x000038000
-	dd 2
-int15_memmap_2: ; 0x0100000 - 0x0400000: available
-	dq 0x000100000
-	dq 0x000300000
+	inc ebx
+	cmp ebx, INT15_MEMMAP_STATIC
+	jb .more
+	xor ebx, ebx ; last entry
+	jmp .more
+
+; int15_memmap_ebda
+; Out:
+;   CF = 0 - FS = EBDA segment with the memory map from the C POST
+;   CF = 1 - no map yet, option ROMs run before the C POST
+int15_memmap_ebda:
+	push ax
+	push ds
+	mov ax, 0x40
+	mov ds, ax
+	mov ax, [ebda_segment]
+	pop ds
+	or ax, ax
+	jz .none
+	mov fs, ax
+	cmp byte [fs:ebda.memmap_count], 0
+	je .none
+	pop ax
+	clc
+	ret
+.none:
+	pop ax
+	stc
+	ret
+
+; int15_ext_kb
+; Out:
+;   AX - KB of RAM from 1 MB up, tested by the POST
+int15_ext_kb:
+	push fs
+	mov ax, EXT_RAM_SIZE
+	call int15_memmap_ebda
+	jc .done
+	mov ax, [fs:ebda.ext_kb]
+.done:
+	pop fs
+	ret
+
+
+; E820 map until the C POST builds the EBDA one, the RAM at 0x4A0000 is
+; left out as the disk cache and shadow RAM may use it
+int15_memmap_static:
+	dq 0x00000000, 0x000A0000	; conventional RAM, no EBDA yet
 	dd 1
-int15_memmap_3: ; 0x0400000 - 0x04A0000: reserved (repeat)
-	dq 0x000400000
-	dq 0x0000A0000
+	dq 0x000C8000, 0x00038000	; ROM
 	dd 2
-int15_memmap_4: ; 0x04A0000 - 0x0500000: available
-	dq 0x0004A0000
-	dq 0x000060000
+	dq 0x00100000, EXT_RAM_SIZE * 1024
 	dd 1
 
-
 int15_system_config:
 	dw 8		; Size
 	db 0xFC		; Computer type (PC)
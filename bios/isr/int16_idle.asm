@@ -0,0 +1,52 @@
+	; Keyboard waits
+	;
+	; INT 16h AH=00h/10h block until a key is in the buffer, halted between
+	; the interrupts instead of spinning. The wait is announced with
+	; INT 15h AX=9002h and every IRQ1 with AX=9102h, for multitasking loaders
+
+; int16_idle
+; INT 16h vector, the reads themselves are done by int16
+int16_idle:
+	cmp ah, 0x00
+	je .wait
+	cmp ah, 0x10
+	jne int16
+.wait:
+	push ax
+	push di
+	push ds
+	mov di, 0x40
+	mov ds, di
+
+	mov di, [keybuf_head]
+	cmp di, [keybuf_tail]
+	jne .ready
+
+	mov ax, 0x9002 ; device busy, keyboard
+	int 0x15
+.check:
+	cli
+	mov di, [keybuf_head]
+	cmp di, [keybuf_tail]
+	jne .ready
+	sti
+	hlt ; woken up by IRQ1 or the timer, STI holds off interrupts until here
+	jmp .check
+
+.ready:
+	pop ds
+	pop di
+	pop ax
+	jmp int16
+
+; int09_post
+; IRQ1 vector, runs int09 and reports the interrupt complete
+int09_post:
+	pushf
+	push cs
+	call int09 ; returns with IRET
+	push ax
+	mov ax, 0x9102 ; interrupt complete, keyboard
+	int 0x15
+	pop ax
+	iret
@@ -6,14 +6,6 @@ int16:
 	mov di, 0x40
 	mov ds, di
 
-	; Wait for interrupt controller to process keyboard interrupt
-	sti
-	push cx
-	mov cx, 5
-	loop $
-	pop cx
-	cli
-
 	cmp ah, 0
 	je keyb_get
 	cmp ah, 1
@@ -0,0 +1,72 @@
+	; SeaPig functions of INT 1Ah, the rest goes to int1a
+	;
+	; AH = F0h - microsecond clock (drivers/usclock.asm)
+	;   AL = 00h - read
+	;     Out: EDX:EAX - microseconds since the boot (48 bits used), CF = 0
+	;   AL = 01h - get the far call entry point
+	;     Out: ES:BX - entry, returns EDX:EAX as above, AH = 0, CF = 0
+	;
+	; AH = F1h - NMI sampling profiler (drivers/profiler.asm)
+	;   AL = 00h - empty the ring and start sampling
+	;     In: CX - PIT clocks per sample, 0 - 100 Hz
+	;   AL = 01h - stop sampling
+	;   AL = 02h - get the ring
+	;     Out: ES:BX - struc profile in the EBDA
+	;   Out: AH = 0, CF = 0 or AH = 86h, CF = 1 - ring not reserved in setup
+
+%include "drivers/usclock.asm"
+%include "drivers/profiler.asm"
+
+int1a_ext:
+	cmp ah, 0xF1
+	je int1a_profile
+	cmp ah, 0xF0
+	jne int1a
+	cmp al, 0x00
+	je int1a_usclock_read
+	cmp al, 0x01
+	je int1a_usclock_entry
+	mov ah, 0x86
+	jmp iret_carry_on
+
+int1a_usclock_read:
+	call usclock_read
+	clc
+	jmp iret_carry
+
+int1a_usclock_entry:
+	push cs
+	pop es
+	mov bx, usclock_far
+	xor ah, ah
+	clc
+	jmp iret_carry
+
+int1a_profile:
+	push ds
+	call profile_segment
+	jc .error
+	cmp al, 0x00
+	je .start
+	cmp al, 0x01
+	je .stop
+	cmp al, 0x02
+	jne .error
+	push ds
+	pop es
+	mov bx, ebda.profile
+	jmp .done
+.start:
+	call profile_start
+	jmp .done
+.stop:
+	call profile_stop
+.done:
+	pop ds
+	xor ah, ah
+	clc
+	jmp iret_carry
+.error:
+	pop ds
+	mov ah, 0x86
+	jmp iret_carry_on
@@ -0,0 +1,362 @@
+;
+; NMIPROF.COM - front end for the BIOS NMI sampling profiler
+;
+; NMIPROF START [clocks] - empty the ring and start sampling, clocks is the
+;                          PIT clock (1193180 Hz) count per sample, 100 Hz
+;                          by default
+; NMIPROF STOP           - stop sampling
+; NMIPROF DUMP           - drain the ring and print the sampled CS:IP
+;                          addresses, most frequent first
+;
+; Needs the "NMI sampling profiler" setup option, see drivers/profiler.asm
+; Build: nasm tools/nmiprof.asm -f bin -o NMIPROF.COM
+;
+
+cpu 486
+org 0x100
+
+%define PROF_TAIL	0x02
+%define PROF_HEAD	0x00
+%define PROF_DROPPED	0x04
+%define PROF_COUNT	0x08
+%define PROF_ENTRIES	0x0C
+%define PROF_RING	0x0E
+
+%define MAX_ADDRS	1024
+
+start:
+	mov si, 0x81
+	call skip_spaces
+	mov di, cmd_start
+	call match_word
+	je do_start
+	mov di, cmd_stop
+	call match_word
+	je do_stop
+	mov di, cmd_dump
+	call match_word
+	je do_dump
+	mov dx, msg_usage
+	jmp exit_msg
+
+do_start:
+	call skip_spaces
+	call parse_number
+	mov cx, ax
+	mov ax, 0xF100
+	int 0x1A
+	jc not_available
+	mov dx, msg_started
+	jmp exit_msg
+
+do_stop:
+	mov ax, 0xF101
+	int 0x1A
+	jc not_available
+	mov dx, msg_stopped
+	jmp exit_msg
+
+not_available:
+	mov dx, msg_not_available
+exit_msg:
+	mov ah, 0x09
+	int 0x21
+	mov ax, 0x4C00
+	int 0x21
+
+do_dump:
+	mov ax, 0xF102
+	int 0x1A
+	jc not_available
+
+	; Drain the ring into addrs, the NMI keeps writing at the head
+	mov word [addr_count], 0
+	mov si, [es:bx + PROF_RING]
+.next:
+	mov di, [es:bx + PROF_TAIL]
+	cmp di, [es:bx + PROF_HEAD]
+	je .drained
+	shl di, 2
+	mov eax, [es:si + di]
+	call add_sample
+	mov ax, [es:bx + PROF_TAIL]
+	inc ax
+	cmp ax, [es:bx + PROF_ENTRIES]
+	jb .no_wrap
+	xor ax, ax
+.no_wrap:
+	mov [es:bx + PROF_TAIL], ax
+	jmp .next
+.drained:
+	mov eax, [es:bx + PROF_COUNT]
+	mov [total], eax
+	mov eax, [es:bx + PROF_DROPPED]
+	mov [dropped], eax
+
+	call sort_addrs
+	mov si, addrs
+	mov cx, [addr_count]
+	jcxz .summary
+.print:
+	mov eax, [si + 4]
+	call print_dec
+	mov dx, msg_at
+	call print
+	mov ax, [si + 2]
+	call print_hex
+	mov dl, ':'
+	call print_char
+	mov ax, [si]
+	call print_hex
+	mov dx, msg_crlf
+	call print
+	add si, 8
+	loop .print
+.summary:
+	mov dx, msg_total
+	call print
+	mov eax, [total]
+	call print_dec
+	mov dx, msg_dropped
+	call print
+	mov eax, [dropped]
+	call print_dec
+	mov dx, msg_other
+	call print
+	mov eax, [other]
+	call print_dec
+	mov dx, msg_crlf
+	jmp exit_msg
+
+; add_sample
+; Counts one sample, new addresses past MAX_ADDRS go to other
+; In:
+;   EAX - CS:IP
+add_sample:
+	push cx
+	push di
+	mov di, addrs
+	mov cx, [addr_count]
+	jcxz .new
+.find:
+	cmp [di], eax
+	je .found
+	add di, 8
+	loop .find
+.new:
+	cmp word [addr_count], MAX_ADDRS
+	jae .other
+	inc word [addr_count]
+	mov [di], eax
+	mov dword [di + 4], 0
+.found:
+	inc dword [di + 4]
+	pop di
+	pop cx
+	ret
+.other:
+	inc dword [other]
+	pop di
+	pop cx
+	ret
+
+; sort_addrs
+; Selection sort of addrs, highest count first
+sort_addrs:
+	mov si, addrs
+	mov cx, [addr_count]
+.outer:
+	cmp cx, 1
+	jbe .done
+	mov di, si
+	mov bx, si
+	mov dx, cx
+.inner:
+	mov eax, [di + 4]
+	cmp eax, [bx + 4]
+	jbe .not_higher
+	mov bx, di
+.not_higher:
+	add di, 8
+	dec dx
+	jnz .inner
+	mov eax, [si]
+	xchg eax, [bx]
+	mov [si], eax
+	mov eax, [si + 4]
+	xchg eax, [bx + 4]
+	mov [si + 4], eax
+	add si, 8
+	dec cx
+	jmp .outer
+.done:
+	ret
+
+; skip_spaces
+; In/Out:
+;   SI - command line pointer
+skip_spaces:
+	cmp byte [si], ' '
+	je .skip
+	cmp byte [si], 0x09
+	jne .done
+.skip:
+	inc si
+	jmp skip_spaces
+.done:
+	ret
+
+; match_word
+; Case insensitive compare of the command line with a word
+; In:
+;   SI - command line pointer
+;   DI - zero terminated uppercase word
+; Out:
+;   ZF = 1 - matched, SI past the word
+match_word:
+	push si
+.next:
+	mov al, [di]
+	test al, al
+	jz .end
+	mov ah, [si]
+	and ah, 0xDF
+	cmp ah, al
+	jne .fail
+	inc si
+	inc di
+	jmp .next
+.end:
+	; Next character must end the word
+	mov al, [si]
+	cmp al, ' '
+	jbe .match
+.fail:
+	pop si
+	or al, 1 ; ZF = 0, AL is never 0 here
+	ret
+.match:
+	add sp, 2
+	xor al, al
+	ret
+
+; parse_number
+; In:
+;   SI - command line pointer
+; Out:
+;   AX - decimal number, 0 if none
+parse_number:
+	xor ax, ax
+.next:
+	movzx dx, byte [si]
+	sub dl, '0'
+	cmp dl, 9
+	ja .done
+	imul ax, 10
+	add ax, dx
+	inc si
+	jmp .next
+.done:
+	ret
+
+; print
+; In:
+;   DX - '$' terminated string
+print:
+	push ax
+	mov ah, 0x09
+	int 0x21
+	pop ax
+	ret
+
+; print_char
+; In:
+;   DL - character
+print_char:
+	push ax
+	mov ah, 0x02
+	int 0x21
+	pop ax
+	ret
+
+; print_hex
+; In:
+;   AX - value, printed as 4 digits
+print_hex:
+	push cx
+	push dx
+	mov cx, 4
+.digit:
+	rol ax, 4
+	mov dl, al
+	and dl, 0x0F
+	add dl, '0'
+	cmp dl, '9'
+	jbe .print
+	add dl, 'A' - '9' - 1
+.print:
+	call print_char
+	loop .digit
+	pop dx
+	pop cx
+	ret
+
+; print_dec
+; In:
+;   EAX - value, right aligned to 10 characters
+print_dec:
+	push bx
+	push cx
+	push edx
+	push di
+	mov ebx, 10
+	mov cx, 10
+	mov di, dec_buf + 10
+.digit:
+	xor edx, edx
+	div ebx
+	add dl, '0'
+	dec di
+	mov [di], dl
+	dec cx
+	test eax, eax
+	jnz .digit
+.pad:
+	jcxz .print
+	dec di
+	mov byte [di], ' '
+	loop .pad
+.print:
+	mov dx, dec_buf
+	call print
+	pop di
+	pop edx
+	pop cx
+	pop bx
+	ret
+
+cmd_start:		db "START", 0
+cmd_stop:		db "STOP", 0
+cmd_dump:		db "DUMP", 0
+
+msg_usage:		db "NMIPROF START [clocks] | STOP | DUMP", 13, 10
+			db "  START  - sample CS:IP every clocks/1193180 s (default 100 Hz)", 13, 10
+			db "  STOP   - stop sampling", 13, 10
+			db "  DUMP   - print the samples taken so far", 13, 10, "$"
+msg_not_available:	db "NMI profiler not available, enable it in the BIOS setup", 13, 10, "$"
+msg_started:		db "Sampling started", 13, 10, "$"
+msg_stopped:		db "Sampling stopped", 13, 10, "$"
+msg_at:			db "  $"
+msg_total:		db "Samples:$"
+msg_dropped:		db ", dropped:$"
+msg_other:		db ", not listed:$"
+msg_crlf:		db 13, 10, "$"
+
+dec_buf:		db "          $"
+
+total:			dd 0
+dropped:		dd 0
+other:			dd 0
+addr_count:		dw 0
+
+addrs: ; MAX_ADDRS entries of dword CS:IP, dword count, past the end of the file
@@ -37,8 +37,17 @@ ENTITY CMOS IS
 		AVR_IO	: INOUT STD_LOGIC;
 		
 		FPGA_VER	: IN	STD_LOGIC_VECTOR(31 downto 0);
-		RESET		: IN	STD_LOGIC
-	);
+		
+		NMI_ENABLE	: OUT	STD_LOGIC; -- to nmi_timer
+		NMI_PERIOD	: OUT	STD_LOGIC_VECTOR(15 downto 0);
+		
+		RESET_REQ	: IN	STD_LOGIC; -- CPU reset request (port 92h, KBC FEh), forwarded to the AVR
+		
+		SHADOW_RE	: OUT	STD_LOGIC_VECTOR(15 downto 0); -- to address_decoder, 16 KB blocks of 0xC0000-0xFFFFF
+		SHADOW_WE	: OUT	STD_LOGIC_VECTOR(15 downto 0);
+		
+		RESET		: IN	STD_LOGIC
+	);
 END CMOS;
 
 ARCHITECTURE Behavioral OF CMOS IS
@@ -75,6 +84,23 @@ ARCHITECTURE Behavioral OF CMOS IS
 	
 	SIGNAL CMOS_WRITE_PROTECT : STD_LOGIC := '0';
 	
+	-- NMI sampling timer registers (0xF8 control, 0xF9-0xFA period)
+	SIGNAL NMI_CTRL			: STD_LOGIC := '0';
+	SIGNAL NMI_PERIOD_REG	: STD_LOGIC_VECTOR(15 downto 0) := x"0000";
+	
+	-- Shadow RAM registers (0xF0-0xF1 read from RAM, 0xF2-0xF3 write to RAM)
+	SIGNAL SHADOW_RE_REG		: STD_LOGIC_VECTOR(15 downto 0) := x"0000";
+	SIGNAL SHADOW_WE_REG		: STD_LOGIC_VECTOR(15 downto 0) := x"0000";
+	
+	-- Shutdown status byte (0x0F), kept over CPU resets
+	SIGNAL SHUTDOWN_CODE		: STD_LOGIC_VECTOR(7 downto 0) := x"00";
+	
+	-- CPU reset request to the AVR, sent between CMOS stores
+	CONSTANT AVR_RESET_REQUEST	: STD_LOGIC_VECTOR(7 downto 0) := x"C3";
+	SIGNAL RESET_SEND			: STD_LOGIC := '0';
+	SIGNAL RESET_SENT			: STD_LOGIC := '0';
+	SIGNAL RESET_C_BIT		: INTEGER RANGE 0 TO 8 := 0;
+	
 	SIGNAL TRANSFER_CONFIG	: STD_LOGIC := '1'; -- Init
 	SIGNAL TRANSFER_CONFIG_NEXT_END : STD_LOGIC := '0';
 	
@@ -126,6 +152,9 @@ BEGIN
 	--
 	-- Store: (FPGA out, AVR in)
 	-- 11110101 [byte 0] [byte 1] [byte 2] ... [byte 31] 10101010
+	--
+	-- CPU reset request: (FPGA out, AVR in), never during a store
+	-- 11000011 0
 	PROCESS(CLK_IN)
 		VARIABLE AVR_OUT_TMP			: STD_LOGIC;
 		VARIABLE CONFIG_TEMP_VAR	: STD_LOGIC_VECTOR (7 downto 0);
@@ -144,7 +173,7 @@ BEGIN
 			
 				IF RECEIVED_CONFIG = '1' AND CONFIG_DO_WRITE = '0' THEN -- When config is received and we are not in write
 					IF TRANSFER_TIMER >= CYCLES_WAIT_TO_TRANSFER THEN -- Timer time out
-						IF CONFIG_DATA_DIRTY = '1' OR TRANSFER_DIRTY = '1' THEN
+						IF (CONFIG_DATA_DIRTY = '1' OR TRANSFER_DIRTY = '1') AND RESET_REQ = '0' THEN -- store after the reset
 							-- Initialize write
 							CONFIG_COUNT <= 0;
 							CONFIG_C_BIT <= 0;
@@ -171,6 +200,15 @@ BEGIN
 			
 			LAST_CONFIG_DATA_DIRTY <= CONFIG_DATA_DIRTY;
 			
+			-- CPU reset request, waits for a running store to finish
+			IF RESET_REQ = '0' THEN
+				RESET_SENT <= '0';
+			ELSIF RECEIVED_CONFIG = '1' AND CONFIG_DO_WRITE = '0' AND RESET_SEND = '0' AND RESET_SENT = '0' THEN
+				RESET_SEND <= '1';
+				RESET_C_BIT <= 0;
+				CFG_SKIP_CLK <= '1';
+			END IF;
+			
 			CFG_WRITER_ADDR <= CONFIG_COUNT;
 			
 			-- if RD or WR became 0, transfer is dirty!!!
@@ -276,6 +314,19 @@ BEGIN
 								TRANSFER_DIRTY <= '1';
 								AVR_OUT <= '0';
 							END IF;
+						ELSIF RESET_SEND = '1' THEN -- CPU reset request, MSB first, then back to idle low
+							IF RESET_C_BIT = 8 THEN
+								AVR_OUT <= '0';
+								RESET_SEND <= '0';
+								RESET_SENT <= '1';
+							ELSE
+								IF AVR_RESET_REQUEST(7 - RESET_C_BIT) = '1' THEN
+									AVR_OUT <= 'Z';
+								ELSE
+									AVR_OUT <= '0';
+								END IF;
+								RESET_C_BIT <= RESET_C_BIT + 1;
+							END IF;
 						END IF; -- CONFIG_DO_WRITE
 					END IF; -- CFG_SKIP_CLK
 					
@@ -288,6 +339,12 @@ BEGIN
 	
 	AVR_IO <= 'Z' WHEN RECEIVED_CONFIG = '0' ELSE AVR_OUT;
 	
+	NMI_ENABLE <= NMI_CTRL;
+	NMI_PERIOD <= NMI_PERIOD_REG;
+	
+	SHADOW_RE <= SHADOW_RE_REG;
+	SHADOW_WE <= SHADOW_WE_REG;
+	
 	RAM_WRITE_VAL <= CFG_WRITER_VAL WHEN TRANSFER_CONFIG = '1' AND BUS_ACCESS = '0' ELSE BUS_WRITER_VAL;
 	RAM_WRITE_ADDR <= CFG_WRITER_ADDR WHEN TRANSFER_CONFIG = '1' AND BUS_ACCESS = '0' ELSE BUS_WRITER_ADDR;
 	RAM_WRITE_EN <= CFG_WRITER_EN WHEN TRANSFER_CONFIG = '1' AND BUS_ACCESS = '0' ELSE BUS_WRITER_EN;
@@ -315,7 +372,7 @@ BEGIN
 	--RAM_OUT <= CMOS_REGISTERS(RAM_WRITE_ADDR); -- also read_addr (async)
 
 
-	PROCESS(CLK_IN, CURRENT_REGISTER, RESET, CMOS_CS, WR, RECEIVED_CONFIG, A0, CMOS_WRITE_PROTECT, RD, SECONDS, MINUTES, HOURS, DAY, MONTH, YEAR, CENTURY, FPGA_VER, RAM_OUT, WEEKDAY, CMOS_IN_RANGE)
+	PROCESS(CLK_IN, CURRENT_REGISTER, RESET, CMOS_CS, WR, RECEIVED_CONFIG, A0, CMOS_WRITE_PROTECT, RD, SECONDS, MINUTES, HOURS, DAY, MONTH, YEAR, CENTURY, FPGA_VER, RAM_OUT, WEEKDAY, CMOS_IN_RANGE, NMI_CTRL, NMI_PERIOD_REG, SHUTDOWN_CODE, SHADOW_RE_REG, SHADOW_WE_REG)
 		VARIABLE DATA_OUT_FINAL		: STD_LOGIC_VECTOR(7 downto 0);
 	BEGIN
 		DATA_OUT_FINAL := x"00";
@@ -325,6 +382,9 @@ BEGIN
 		
 		IF RESET = '1' THEN
 			CMOS_WRITE_PROTECT <= '0';
+			NMI_CTRL <= '0';
+			SHADOW_RE_REG <= x"0000"; -- boot from the ROM
+			SHADOW_WE_REG <= x"0000";
 		END IF;
 
 		IF CMOS_CS = '0' AND RESET = '0' THEN
@@ -351,6 +411,23 @@ BEGIN
 									CMOS_WRITE_PROTECT <= '1';
 								END IF;
 								
+							WHEN x"0F" => -- Shutdown status, not cleared by RESET
+								SHUTDOWN_CODE <= DATA_IN;
+							WHEN x"F0" => -- Shadow RAM read, 0xC0000-0xDFFFF, bit n - block n
+								SHADOW_RE_REG(7 downto 0) <= DATA_IN;
+							WHEN x"F1" => -- Shadow RAM read, 0xE0000-0xFFFFF
+								SHADOW_RE_REG(15 downto 8) <= DATA_IN;
+							WHEN x"F2" => -- Shadow RAM write, 0xC0000-0xDFFFF
+								SHADOW_WE_REG(7 downto 0) <= DATA_IN;
+							WHEN x"F3" => -- Shadow RAM write, 0xE0000-0xFFFFF
+								SHADOW_WE_REG(15 downto 8) <= DATA_IN;
+							WHEN x"F8" => -- NMI timer control, bit 0 - enable
+								NMI_CTRL <= DATA_IN(0);
+							WHEN x"F9" => -- NMI period low byte (PIT clocks)
+								NMI_PERIOD_REG(7 downto 0) <= DATA_IN;
+							WHEN x"FA" => -- NMI period high byte
+								NMI_PERIOD_REG(15 downto 8) <= DATA_IN;
+								
 							WHEN OTHERS =>
 								BUS_WRITER_VAL <= DATA_IN;
 						END CASE;
@@ -402,6 +479,23 @@ BEGIN
 							-- Result: 00000110 
 							DATA_OUT_FINAL := "00000110";
 						
+						WHEN x"0F" => -- Shutdown status
+							DATA_OUT_FINAL := SHUTDOWN_CODE;
+						WHEN x"F0" =>
+							DATA_OUT_FINAL := SHADOW_RE_REG(7 downto 0);
+						WHEN x"F1" =>
+							DATA_OUT_FINAL := SHADOW_RE_REG(15 downto 8);
+						WHEN x"F2" =>
+							DATA_OUT_FINAL := SHADOW_WE_REG(7 downto 0);
+						WHEN x"F3" =>
+							DATA_OUT_FINAL := SHADOW_WE_REG(15 downto 8);
+						WHEN x"F8" =>
+							DATA_OUT_FINAL := "0000000" & NMI_CTRL;
+						WHEN x"F9" =>
+							DATA_OUT_FINAL := NMI_PERIOD_REG(7 downto 0);
+						WHEN x"FA" =>
+							DATA_OUT_FINAL := NMI_PERIOD_REG(15 downto 8);
+						
 						WHEN x"FC" =>
 							DATA_OUT_FINAL := FPGA_VER(31 downto 24);
 						WHEN x"FD" =>
@@ -35,6 +35,9 @@ ENTITY address_decoder IS
 		
 		INT_ACK			: IN	STD_LOGIC; -- Override address decoder while interrupt ack is in progress
 		
+		SHADOW_RE		: IN	STD_LOGIC_VECTOR(15 DOWNTO 0); -- Shadow RAM, 16 KB blocks of 0x0C0000 to 0x0FFFFF (CMOS 0xF0-0xF3)
+		SHADOW_WE		: IN	STD_LOGIC_VECTOR(15 DOWNTO 0);
+		
 		RAM_CS			: OUT	STD_LOGIC; 
 		ROM_CS			: OUT	STD_LOGIC; -- ROM_CS is connected just to OE. Allow it only at READ
 		PIC_CS			: OUT	STD_LOGIC;
@@ -43,6 +46,7 @@ ENTITY address_decoder IS
 		O61_CS			: OUT STD_LOGIC; -- Write only 61h output port (latch used)
 		ISA_CS			: OUT	STD_LOGIC;
 		CMOS_CS			: OUT STD_LOGIC;
+		SYSCTL_CS		: OUT STD_LOGIC; -- System control port A (92h)
 		
 		OUT_KEN			: OUT	STD_LOGIC;
 		OUT_BS16			: OUT	STD_LOGIC;
@@ -60,6 +64,9 @@ ARCHITECTURE Behavioral OF address_decoder IS
 	SIGNAL O61_CS_I			: STD_LOGIC;
 	SIGNAL ISA_CS_I			: STD_LOGIC;
 	SIGNAL CMOS_CS_I			: STD_LOGIC;
+	SIGNAL SYSCTL_CS_I		: STD_LOGIC;
+	
+	SIGNAL SHADOW_HIT			: STD_LOGIC; -- '1' - RAM serves this 0x0C0000 to 0x0FFFFF cycle
 	
 	SIGNAL RAM_CACHE			: STD_LOGIC; -- negated
 	SIGNAL ROM_CACHE			: STD_LOGIC; -- negated
@@ -68,14 +75,32 @@ BEGIN
 
 	ADDR_INT <= UNSIGNED(ADDR_IN & ADDR_A1 & ADDR_A0);
 	
+	-- Shadow RAM: 0x0C0000 to 0x0FFFFF in 16 KB blocks, same SRAM as the 0x4C0000 to 0x4FFFFF wrap
+	-- Reads come from RAM when the block's SHADOW_RE bit is set, writes go to RAM when its SHADOW_WE bit is set
+	-- RE = 0, WE = 1 lets the BIOS copy a ROM onto itself, RE = 1, WE = 0 is write protected shadow
+	PROCESS(ADDR_INT, ADDR_31, CPU_MIO, CPU_WR, SHADOW_RE, SHADOW_WE)
+		VARIABLE SHADOW_BLOCK	: INTEGER RANGE 0 TO 15;
+	BEGIN
+		SHADOW_HIT <= '0';
+		SHADOW_BLOCK := to_integer(ADDR_INT(17 downto 14));
+		IF (ADDR_31 = '0') AND (CPU_MIO = '1') AND (ADDR_INT(23 downto 18) = "000011") THEN
+			IF CPU_WR = '0' THEN
+				SHADOW_HIT <= SHADOW_RE(SHADOW_BLOCK);
+			ELSE
+				SHADOW_HIT <= SHADOW_WE(SHADOW_BLOCK);
+			END IF;
+		END IF;
+	END PROCESS;
+	
 	-- RAM CS: MEM, 0x000000 to 0x09FFFF, 0x100000 to 0x3FFFFF and 0x4A0000 to 0x4FFFFF (wrap to access 384KB memory hole)
-	PROCESS(ADDR_INT, ADDR_31, CPU_MIO, RAM_CACHEABLE)
+	-- and the shadowed blocks of 0x0C0000 to 0x0FFFFF
+	PROCESS(ADDR_INT, ADDR_31, CPU_MIO, RAM_CACHEABLE, SHADOW_HIT)
 	BEGIN
 		RAM_CS <= '1'; -- inactive
 		RAM_CACHE <= '1';
 		IF NOT ((ADDR_31 = '1') OR (CPU_MIO = '0')) THEN -- inactive if addr>2GB or IO 
 			-- decode
-			IF (ADDR_INT < x"0A0000") OR (ADDR_INT >= x"100000" AND ADDR_INT < x"400000") OR (ADDR_INT >= x"4A0000" AND ADDR_INT < x"500000") THEN
+			IF (ADDR_INT < x"0A0000") OR (ADDR_INT >= x"100000" AND ADDR_INT < x"400000") OR (ADDR_INT >= x"4A0000" AND ADDR_INT < x"500000") OR (SHADOW_HIT = '1') THEN
 				RAM_CS <= '0';
 				IF RAM_CACHEABLE = '1' THEN
 					RAM_CACHE <= '0';
@@ -85,7 +110,7 @@ BEGIN
 	END PROCESS;
 	
 	-- ROM MEM CS: MEM, 0x0C8000 to 0x100000 and 2GB to the end (224KB in lower area. ROM IS 256KB, lower 32KB is accessible after 2GB)
-	PROCESS(ADDR_INT, ADDR_31, CPU_MIO, ROM_CACHEABLE)
+	PROCESS(ADDR_INT, ADDR_31, CPU_MIO, ROM_CACHEABLE, SHADOW_HIT)
 	BEGIN
 		ROM_CS_I <= '1'; -- inactive
 		ROM_CACHE <= '1';
@@ -97,7 +122,7 @@ BEGIN
 					ROM_CACHE <= '0';
 				END IF;
 			ELSE 
-				IF (ADDR_INT >= x"0C8000") AND (ADDR_INT < x"100000") THEN -- If in range 0C8000 to 100000
+				IF (ADDR_INT >= x"0C8000") AND (ADDR_INT < x"100000") AND (SHADOW_HIT = '0') THEN -- If in range 0C8000 to 100000 and not shadowed
 					ROM_CS_I <= '0';
 					IF ROM_CACHEABLE = '1' THEN
 						ROM_CACHE <= '0';
@@ -178,22 +203,35 @@ BEGIN
 	
 	CMOS_CS <= CMOS_CS_I;
 	
+	-- System control port A: IO, 92h
+	PROCESS(ADDR_INT, CPU_MIO)
+	BEGIN
+		SYSCTL_CS_I <= '1';
+		IF (CPU_MIO = '0') THEN --       xxXXxxXX76543210
+			IF (ADDR_INT(15 downto 0)) = "0000000010010010" THEN
+				SYSCTL_CS_I <= '0';
+			END IF;
+		END IF;
+	END PROCESS;
+	
+	SYSCTL_CS <= SYSCTL_CS_I;
+	
 	
 	
 	-- Special - IO and MEM both decoding
 	-- ISA CS: MEM, 0x0A0000 to 0x0C8000 (160KB window) and rest of IO
-	PROCESS(ADDR_INT, ADDR_31, CPU_MIO, PIC_CS_I, PIT_CS_I, PS2_CS_I, O61_CS_I, CMOS_CS_I, INT_ACK)
+	PROCESS(ADDR_INT, ADDR_31, CPU_MIO, PIC_CS_I, PIT_CS_I, PS2_CS_I, O61_CS_I, CMOS_CS_I, SYSCTL_CS_I, INT_ACK, SHADOW_HIT)
 	BEGIN
 		IF INT_ACK = '1' THEN -- ISA can be active if no interrupt is in progress
 			ISA_CS_I <= '1'; -- inactive
 			IF NOT ((ADDR_31 = '1') OR (CPU_MIO = '0')) THEN -- inactive if addr>2GB or IO 
 				-- decode
-				IF (ADDR_INT >= x"0A0000") AND (ADDR_INT < x"0C8000") THEN
+				IF (ADDR_INT >= x"0A0000") AND (ADDR_INT < x"0C8000") AND (SHADOW_HIT = '0') THEN
 					ISA_CS_I <= '0';
 				END IF;
 			ELSE 
 				-- All other IO accesses
-				IF (CPU_MIO = '0') AND (NOT ((PIC_CS_I = '0') OR (PIT_CS_I = '0') OR (PS2_CS_I = '0') OR (O61_CS_I = '0') OR (CMOS_CS_I = '0'))) THEN
+				IF (CPU_MIO = '0') AND (NOT ((PIC_CS_I = '0') OR (PIT_CS_I = '0') OR (PS2_CS_I = '0') OR (O61_CS_I = '0') OR (CMOS_CS_I = '0') OR (SYSCTL_CS_I = '0'))) THEN
 					ISA_CS_I <= '0';
 				END IF;
 			END IF;
@@ -206,7 +244,7 @@ BEGIN
 	
 	
 	-- BS8/16 DECODER
-	PROCESS(CPU_MIO, ROM_CS_I, PIC_CS_I, PIT_CS_I, PS2_CS_I, O61_CS_I, ISA_CS_I, CMOS_CS_I)
+	PROCESS(CPU_MIO, ROM_CS_I, PIC_CS_I, PIT_CS_I, PS2_CS_I, O61_CS_I, ISA_CS_I, CMOS_CS_I, SYSCTL_CS_I)
 	BEGIN
 	--		RAM_CS
 	--		ROM_CS
@@ -230,7 +268,7 @@ BEGIN
 		END IF;
 		
 		-- IO devices
-		IF (PIC_CS_I = '0') OR (PIT_CS_I = '0') OR (PS2_CS_I = '0') OR (O61_CS_I = '0') OR (CMOS_CS_I = '0') THEN
+		IF (PIC_CS_I = '0') OR (PIT_CS_I = '0') OR (PS2_CS_I = '0') OR (O61_CS_I = '0') OR (CMOS_CS_I = '0') OR (SYSCTL_CS_I = '0') THEN
 			-- No need to check is CPU_MIO is pointing to IO because all of the signals above check it before
 			OUT_BS8 <= '0';
 		END IF;
@@ -116,7 +116,7 @@ ARCHITECTURE Behavioral of m8sbc_main is
 	-- CONSTANTS
 	-- Update Divider in CLKGEN!
 	
-	CONSTANT FPGA_VER						: STD_LOGIC_VECTOR(31 downto 0) := x"48860001"; -- first 2 bytes - chipset ident, last 2 bytes - version
+	CONSTANT FPGA_VER						: STD_LOGIC_VECTOR(31 downto 0) := x"48860004"; -- first 2 bytes - chipset ident, last 2 bytes - version
 	
 	
 	CONSTANT REVERSE_CLOCK				: STD_LOGIC	:= '0'; -- Use 1 for 12 MHz, for 16> use 0
@@ -241,6 +241,9 @@ ARCHITECTURE Behavioral of m8sbc_main is
 			
 			INT_ACK			: IN	STD_LOGIC;
 			
+			SHADOW_RE		: IN	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			SHADOW_WE		: IN	STD_LOGIC_VECTOR(15 DOWNTO 0);
+			
 			RAM_CS			: OUT	STD_LOGIC; 
 			ROM_CS			: OUT	STD_LOGIC; -- ROM_CS, will activate only on READ
 			PIC_CS			: OUT	STD_LOGIC;
@@ -249,6 +252,7 @@ ARCHITECTURE Behavioral of m8sbc_main is
 			O61_CS			: OUT STD_LOGIC; -- Write only 61h output port (latch used)
 			ISA_CS			: OUT	STD_LOGIC;
 			CMOS_CS			: OUT STD_LOGIC;
+			SYSCTL_CS		: OUT STD_LOGIC;
 			
 			OUT_KEN			: OUT	STD_LOGIC;
 			OUT_BS16			: OUT	STD_LOGIC;
@@ -337,9 +341,29 @@ ARCHITECTURE Behavioral of m8sbc_main is
 			AVR_IO	: INOUT STD_LOGIC;
 			
 			FPGA_VER	: IN	STD_LOGIC_VECTOR(31 downto 0);
+			
+			NMI_ENABLE	: OUT	STD_LOGIC;
+			NMI_PERIOD	: OUT	STD_LOGIC_VECTOR(15 downto 0);
+			
+			RESET_REQ	: IN	STD_LOGIC;
+			
+			SHADOW_RE	: OUT	STD_LOGIC_VECTOR(15 downto 0);
+			SHADOW_WE	: OUT	STD_LOGIC_VECTOR(15 downto 0);
+			
 			RESET		: IN	STD_LOGIC
 		);
 	END COMPONENT;
+	
+	COMPONENT nmi_timer IS
+		PORT (
+			CLK_PIT		: IN	STD_LOGIC;
+			RESET			: IN	STD_LOGIC;
+			ENABLE		: IN	STD_LOGIC;
+			PERIOD		: IN	STD_LOGIC_VECTOR(15 downto 0);
+			
+			NMI_OUT		: OUT	STD_LOGIC
+		);
+	END COMPONENT;
 
 
 
@@ -376,6 +400,7 @@ ARCHITECTURE Behavioral of m8sbc_main is
 	SIGNAL	I_CS_O61			: STD_LOGIC;
 	SIGNAL	I_CS_ISA			: STD_LOGIC;
 	SIGNAL	I_CS_CMOS		: STD_LOGIC;
+	SIGNAL	I_CS_SYSCTL		: STD_LOGIC;
 	
 	SIGNAL	S_EN				: STD_LOGIC;
 	SIGNAL	S_ISA_EN			: STD_LOGIC;
@@ -401,6 +426,15 @@ ARCHITECTURE Behavioral of m8sbc_main is
 	
 	SIGNAL	O_CMOS_DATA_OUT	: STD_LOGIC_VECTOR(7 downto 0);
 	
+	SIGNAL	O_NMI_ENABLE	: STD_LOGIC;
+	SIGNAL	O_NMI_PERIOD	: STD_LOGIC_VECTOR(15 downto 0);
+	SIGNAL	O_NMI				: STD_LOGIC;
+	
+	SIGNAL	CPU_RESET_REQ	: STD_LOGIC := '0';
+	
+	SIGNAL	O_SHADOW_RE		: STD_LOGIC_VECTOR(15 downto 0);
+	SIGNAL	O_SHADOW_WE		: STD_LOGIC_VECTOR(15 downto 0);
+	
 	SIGNAL	I_INT_ACK		: STD_LOGIC;
 	
 	SIGNAL	EXTRA_BS8		: STD_LOGIC;
@@ -489,6 +523,9 @@ BEGIN
 		
 		INT_ACK			=> I_INT_ACK,
 		
+		SHADOW_RE		=> O_SHADOW_RE, -- from CMOS registers 0xF0-0xF3
+		SHADOW_WE		=> O_SHADOW_WE,
+		
 		-- outputs
 		RAM_CS			=> I_CS_RAM, -- to ADRDECODER
 		ROM_CS			=> I_CS_ROM, -- direct out
@@ -497,6 +534,7 @@ BEGIN
 		PS2_CS			=> I_CS_PS2, -- to KBCTRL
 		O61_CS			=> I_CS_O61, -- to LE 
 		CMOS_CS			=> I_CS_CMOS,
+		SYSCTL_CS		=> I_CS_SYSCTL,
 		ISA_CS			=> I_CS_ISA, -- to ISA logic
 		
 		OUT_KEN			=> CPU_O_KEN, -- direct out
@@ -577,9 +615,27 @@ BEGIN
 		AVR_IO	=> AVR_IO,
 		
 		FPGA_VER	=> FPGA_VER,
+		
+		NMI_ENABLE	=> O_NMI_ENABLE,
+		NMI_PERIOD	=> O_NMI_PERIOD,
+		
+		RESET_REQ	=> CPU_RESET_REQ,
+		
+		SHADOW_RE	=> O_SHADOW_RE,
+		SHADOW_WE	=> O_SHADOW_WE,
+		
 		RESET		=> RESET_SYS_IN
 	);
 	
+	NMITIMER: nmi_timer PORT MAP(
+		CLK_PIT		=> CLK_PIT,
+		RESET			=> RESET_SYS_IN,
+		ENABLE		=> O_NMI_ENABLE,
+		PERIOD		=> O_NMI_PERIOD,
+		
+		NMI_OUT		=> O_NMI -- sampling profiler (BIOS INT 02h)
+	);
+	
 	O_CPU_16BTR <= O_BHE;
 	
 	I_INT_ACK <= '0' WHEN (CPU_IN_DC = '0' AND CPU_IN_MIO = '0') ELSE '1';
@@ -604,7 +660,7 @@ BEGIN
 	O_BS16 <= '1' WHEN I_INT_ACK = '0' ELSE EXTRA_BS16;
 	
 	-- WR/RD gen activator and WAITSTATE selector
-	PROCESS(I_CS_ROM, I_CS_PIC, I_CS_PIT, I_CS_O61, I_CS_ISA, I_INT_ACK)
+	PROCESS(I_CS_ROM, I_CS_PIC, I_CS_PIT, I_CS_O61, I_CS_PS2, I_CS_CMOS, I_CS_SYSCTL, I_CS_ISA, I_INT_ACK)
 		VARIABLE SEL_BUS	: STD_LOGIC_VECTOR(3 downto 0);
 	BEGIN
 	
@@ -615,7 +671,7 @@ BEGIN
 		-- PIC ignores CS on INT_ACK
 		-- We send two INTA pulses to PIC (override IO_RD)
 	
-		SEL_BUS := I_CS_ROM & (I_CS_PIC AND I_CS_PIT AND I_CS_O61 AND I_CS_PS2 AND I_CS_CMOS) & I_CS_ISA & I_INT_ACK; 
+		SEL_BUS := I_CS_ROM & (I_CS_PIC AND I_CS_PIT AND I_CS_O61 AND I_CS_PS2 AND I_CS_CMOS AND I_CS_SYSCTL) & I_CS_ISA & I_INT_ACK; 
 		
 		S_EN <= '1';
 		S_ISA_EN <= '1';
@@ -661,7 +717,7 @@ BEGIN
 	PIT_CS	<= I_CS_PIT;
 	
 	
-	PROCESS(O_IO_RD, CPU_IN_WR, I_CS_PS2, I_CS_O61, I_CS_CMOS, CPU_IN_ADDR, O_PS2_STATUS, O_PS2_DATA, O61_DATA_L, O_CMOS_DATA_OUT) -- Output from the FPGA to the CPU driver (Data)
+	PROCESS(O_IO_RD, CPU_IN_WR, I_CS_PS2, I_CS_O61, I_CS_CMOS, I_CS_SYSCTL, CPU_IN_ADDR, O_PS2_STATUS, O_PS2_DATA, O61_DATA_L, O_CMOS_DATA_OUT) -- Output from the FPGA to the CPU driver (Data)
 	BEGIN
 		O_CPU_DATA <= "ZZZZZZZZ";
 		O_CPU_DATA_P_O <= '0';
@@ -687,6 +743,10 @@ BEGIN
 				ELSIF (I_CS_CMOS = '0') THEN -- CMOS read
 					O_CPU_DATA <= O_CMOS_DATA_OUT;
 					O_CPU_DATA_P_O <= '1';
+					
+				ELSIF (I_CS_SYSCTL = '0') THEN -- Port 92h read, A20 is always enabled
+					O_CPU_DATA <= "00000010";
+					O_CPU_DATA_P_O <= '1';
 				END IF;
 			END IF;
 		END IF;
@@ -721,6 +781,36 @@ BEGIN
 	
 	
 	
+	-- CPU reset request
+	-- Port 92h bit 0 (fast reset) or keyboard controller command FEh at port 64h. The CMOS block passes it
+	-- to the AVR over the CMOS link, the AVR pulses RESET for a few microseconds and RESET clears the request
+	-- CMOS, the shutdown status byte and the AVR link survive it, so the BIOS can resume at 40h:67h
+
+	PROCESS(CLK_CPU, RESET_SYS_IN)
+	BEGIN
+		IF RESET_SYS_IN = '1' THEN
+		
+			CPU_RESET_REQ <= '0';
+		
+		ELSE
+		
+			IF FALLING_EDGE(CLK_CPU) THEN
+				IF (O_IO_WR = '0') THEN
+					IF (I_CS_SYSCTL = '0') AND (CPU_DATA(0) = '1') THEN
+						CPU_RESET_REQ <= '1';
+					END IF;
+					IF (I_CS_PS2 = '0') AND (CPU_IN_ADDR(2) = '1') AND (CPU_DATA = x"FE") THEN
+						CPU_RESET_REQ <= '1';
+					END IF;
+				END IF;
+			END IF;
+			
+		END IF;
+		
+	END PROCESS;
+	
+	
+	
 	CLK_OUT_CPU 	<= NOT CLK_CPU WHEN REVERSE_CLOCK = '1' ELSE CLK_CPU; -- For some timings? reason, running below 16 MHz requires inverting clock
 	CLK_OUT_PIT		<= CLK_PIT;
 	CLK_OUT_ISA		<= CLK_ISA;
@@ -737,7 +827,7 @@ BEGIN
 	-- ISA_IO_READY is 0 = wait
 	CPU_OUT_RDY		<= O_RDY_ISA OR O_RDY_RAM OR O_RDY_WRRD; -- TEMP (???)
 
-	CPU_OUT_NMI		<= '0';
+	CPU_OUT_NMI		<= O_NMI;
 	PIC_INTA			<= O_IO_RD WHEN I_INT_ACK = '0' ELSE '1'; -- Int ack for 8259 is like RD. 486 holds INTA state both reads so we need to use IO_RD feature
 
 	CPU_OUT_KEN		<= CPU_O_KEN WHEN TRUE ELSE '1'; -- To fix: doesn't work on RAM
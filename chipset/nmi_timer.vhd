@@ -0,0 +1,76 @@
+----------------------------------------------------------------------------------
+-- Company: maniek86.xyz
+-- Engineer: Piotr Grzesik
+-- 
+-- Create Date:    18:40:12 10/17/2026 
+-- Design Name: 
+-- Module Name:    nmi_timer - Behavioral 
+-- Project Name: Hamster 1 chipset
+-- Target Devices: M8SBC-486 REV 1.0
+-- Tool versions: 
+-- Description: Periodic NMI for the BIOS sampling profiler
+--
+-- Dependencies: 
+--
+-- Revision: 
+-- Revision 0.01 - File Created
+-- Additional Comments: 
+-- Programmed through CMOS registers 0xF8 (bit 0 - enable) and 0xF9-0xFA
+-- (period in PIT clocks, 1.193 MHz). The 486 NMI is edge triggered, so
+-- every period starts with a short high pulse
+--
+----------------------------------------------------------------------------------
+LIBRARY IEEE;
+USE IEEE.STD_LOGIC_1164.ALL;
+USE IEEE.NUMERIC_STD.ALL;
+
+ENTITY nmi_timer IS
+	PORT (
+		CLK_PIT		: IN	STD_LOGIC; -- 1.193 MHz
+		RESET			: IN	STD_LOGIC;
+		ENABLE		: IN	STD_LOGIC;
+		PERIOD		: IN	STD_LOGIC_VECTOR(15 downto 0);
+		
+		NMI_OUT		: OUT	STD_LOGIC
+	);
+END nmi_timer;
+
+ARCHITECTURE Behavioral OF nmi_timer IS
+	CONSTANT MIN_PERIOD	: INTEGER := 119; -- 10 kHz max, leaves the CPU time between samples
+	CONSTANT PULSE_WIDTH	: INTEGER := 2;   -- PIT clocks, far over the 4 CPU clocks the 486 needs
+	
+	SIGNAL COUNTER			: UNSIGNED(15 downto 0) := x"0000";
+	SIGNAL NMI_L			: STD_LOGIC := '0';
+	SIGNAL S1_ENABLE		: STD_LOGIC := '0'; -- written in the CPU clock domain
+	SIGNAL S2_ENABLE		: STD_LOGIC := '0';
+BEGIN
+
+	PROCESS(CLK_PIT, RESET)
+	BEGIN
+		IF RESET = '1' THEN
+			COUNTER <= x"0000";
+			NMI_L <= '0';
+			S1_ENABLE <= '0';
+			S2_ENABLE <= '0';
+		ELSIF RISING_EDGE(CLK_PIT) THEN
+			S1_ENABLE <= ENABLE; -- 2-FF sync
+			S2_ENABLE <= S1_ENABLE;
+			
+			IF S2_ENABLE = '0' OR UNSIGNED(PERIOD) < MIN_PERIOD THEN
+				COUNTER <= x"0000";
+				NMI_L <= '0';
+			ELSIF COUNTER >= UNSIGNED(PERIOD) - 1 THEN
+				COUNTER <= x"0000";
+				NMI_L <= '1'; -- rising edge = NMI
+			ELSE
+				COUNTER <= COUNTER + 1;
+				IF COUNTER = PULSE_WIDTH - 1 THEN
+					NMI_L <= '0';
+				END IF;
+			END IF;
+		END IF;
+	END PROCESS;
+	
+	NMI_OUT <= NMI_L;
+
+END Behavioral;